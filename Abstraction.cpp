@@ -0,0 +1,312 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#include <iostream>
+
+#include "Abstraction.h"
+#include "Model.h"
+#include "Stats.h"
+
+namespace Abstraction {
+
+  // An abstraction renumbers only latch variables: invisible latches
+  // become the inputs after the concrete ones, and visible latches
+  // follow them, in the same order; ANDs keep their variables.  var
+  // maps concrete to abstract variables and back.
+  struct Map {
+    vector<unsigned> var, concrete;
+    unsigned lit(unsigned l) const { return 2 * var[l/2] + (l & 1); }
+  };
+
+  static aiger * abstractAiger(aiger * aig, const vector<bool> & visible, 
+                               Map & map) {
+    unsigned inputs = aig->num_inputs, latches = aig->num_latches;
+    map.var.resize(aig->maxvar + 1);
+    for (unsigned v = 0; v <= aig->maxvar; ++v) map.var[v] = v;
+    unsigned next = inputs + 1;
+    for (unsigned i = 0; i < latches; ++i)
+      if (!visible[i]) map.var[inputs + 1 + i] = next++;
+    for (unsigned i = 0; i < latches; ++i)
+      if (visible[i]) map.var[inputs + 1 + i] = next++;
+    map.concrete.resize(map.var.size());
+    for (unsigned v = 0; v < map.var.size(); ++v) 
+      map.concrete[map.var[v]] = v;
+
+    aiger * abs = aiger_init();
+    for (unsigned i = 0; i < inputs; ++i)
+      aiger_add_input(abs, aig->inputs[i].lit, aig->inputs[i].name);
+    for (unsigned i = 0; i < latches; ++i)
+      if (!visible[i])
+        aiger_add_input(abs, map.lit(aig->latches[i].lit), 
+                        aig->latches[i].name);
+    for (unsigned i = 0; i < latches; ++i)
+      if (visible[i]) {
+        const aiger_symbol & l = aig->latches[i];
+        aiger_add_latch(abs, map.lit(l.lit), map.lit(l.next), l.name);
+        aiger_add_reset(abs, map.lit(l.lit), 
+                        l.reset < 2 ? l.reset : map.lit(l.reset));
+      }
+    for (unsigned i = 0; i < aig->num_ands; ++i)
+      aiger_add_and(abs, aig->ands[i].lhs, map.lit(aig->ands[i].rhs0), 
+                    map.lit(aig->ands[i].rhs1));
+    for (unsigned i = 0; i < aig->num_outputs; ++i)
+      aiger_add_output(abs, map.lit(aig->outputs[i].lit), 
+                       aig->outputs[i].name);
+    for (unsigned i = 0; i < aig->num_bad; ++i)
+      aiger_add_bad(abs, map.lit(aig->bad[i].lit), aig->bad[i].name);
+    for (unsigned i = 0; i < aig->num_constraints; ++i)
+      aiger_add_constraint(abs, map.lit(aig->constraints[i].lit), 
+                           aig->constraints[i].name);
+    return abs;
+  }
+
+  static Minisat::Lit mapLit(const vector<unsigned> & var, Minisat::Lit l) {
+    return Minisat::mkLit((Minisat::Var) var[Minisat::var(l)], 
+                          Minisat::sign(l));
+  }
+
+  static LitVec mapLits(const vector<unsigned> & var, const LitVec & lits) {
+    LitVec rv;
+    for (LitVec::const_iterator i = lits.begin(); i != lits.end(); ++i)
+      rv.push_back(mapLit(var, *i));
+    return rv;
+  }
+
+  // The latches that the property and the constraints read through
+  // ANDs alone, to start from.
+  static void support(aiger * aig, unsigned propertyIndex, 
+                      vector<bool> & visible) {
+    unsigned inputs = aig->num_inputs, latches = aig->num_latches;
+    vector<unsigned> stack;
+    stack.push_back(aig->num_bad > 0 ? aig->bad[propertyIndex].lit 
+                    : aig->outputs[propertyIndex].lit);
+    for (unsigned i = 0; i < aig->num_constraints; ++i)
+      stack.push_back(aig->constraints[i].lit);
+    vector<bool> seen(aig->maxvar + 1, false);
+    while (!stack.empty()) {
+      unsigned v = stack.back() / 2;
+      stack.pop_back();
+      if (seen[v]) continue;
+      seen[v] = true;
+      if (v > inputs && v <= inputs + latches)
+        visible[v - inputs - 1] = true;
+      else if (v > inputs + latches) {
+        const aiger_and & a = aig->ands[v - inputs - latches - 1];
+        stack.push_back(a.rhs0);
+        stack.push_back(a.rhs1);
+      }
+    }
+  }
+
+  // The values of the (primed) variables [begin, end) in slv's model.
+  static void values(Model & model, const SatSolver & slv, 
+                     VarVec::const_iterator begin, VarVec::const_iterator end,
+                     bool primed, LitVec & out) {
+    for (VarVec::const_iterator i = begin; i != end; ++i) {
+      Minisat::Var v = primed ? model.primeVar(*i).var() : i->var();
+      Minisat::lbool val = slv.modelValue(v);
+      if (val != Minisat::l_Undef) 
+        out.push_back(i->lit(val == Minisat::l_False));
+    }
+  }
+
+  // Replays the abstract counterexample w, mapped to the concrete
+  // model's variables, on the concrete model: step by step from the
+  // initial states, each step constrained to the next abstract
+  // state, which includes the values it assumes for invisible
+  // latches.  Returns true with the concrete witness if every step
+  // succeeds; otherwise fills refine with the latch variables of the
+  // final conflict at the first step that fails.
+  static bool concretize(Model & concrete, const vector<IC3::Step> & w, 
+                         vector<IC3::Step> & cex, 
+                         vector<Minisat::Var> & refine) {
+    if (w.empty()) return false;
+    // the concrete model's variables are those of the AIG
+    size_t firstLatch = concrete.beginLatches() - concrete.beginInputs() + 1,
+      lastLatch = concrete.endLatches() - concrete.beginInputs();
+    auto isLatch = [&](Minisat::Var v) { 
+      return (size_t) v >= firstLatch && (size_t) v <= lastLatch;
+    };
+    // each step's latch values, including those of invisible latches
+    // (inputs of the abstract model), and its input values
+    vector<LitVec> states(w.size()), inputs(w.size());
+    for (size_t t = 0; t < w.size(); ++t) {
+      states[t] = w[t].latches;
+      for (LitVec::const_iterator i = w[t].inputs.begin(); 
+           i != w[t].inputs.end(); ++i)
+        (isLatch(Minisat::var(*i)) ? states[t] : inputs[t])
+          .push_back(*i);
+    }
+
+    LitVec current;  // concrete state at step t > 0
+    bool rv = true;
+    for (size_t t = 0; t + 1 < w.size() || t == 0; ++t) {
+      bool last = t + 1 >= w.size() - 1;
+      SatSolver * slv = concrete.newSolver();
+      if (t == 0) concrete.loadInitialCondition(*slv);
+      if (w.size() == 1) 
+        concrete.loadError(*slv);
+      else
+        concrete.loadTransitionRelation(*slv);
+      Minisat::vec<Minisat::Lit> assumps;
+      const LitVec & now = t == 0 ? states[0] : current;
+      for (LitVec::const_iterator i = now.begin(); i != now.end(); ++i)
+        assumps.push(*i);
+      for (LitVec::const_iterator i = inputs[t].begin(); 
+           i != inputs[t].end(); ++i)
+        assumps.push(*i);
+      if (w.size() == 1)
+        assumps.push(concrete.error());
+      else {
+        for (LitVec::const_iterator i = states[t+1].begin(); 
+             i != states[t+1].end(); ++i)
+          assumps.push(concrete.primeLit(*i));
+        if (last) {
+          for (LitVec::const_iterator i = inputs[t+1].begin(); 
+               i != inputs[t+1].end(); ++i)
+            assumps.push(concrete.primeLit(*i));
+          assumps.push(concrete.primedError());
+        }
+      }
+      if (slv->solve(assumps) != Minisat::l_True) {
+        // the invisible latches that the concrete model disagrees on,
+        // now or (the primed ones) next
+        for (int i = 0; i < assumps.size(); ++i) {
+          Minisat::Lit a = assumps[i];
+          if (!slv->failed(a)) continue;
+          Minisat::Lit u = concrete.unprimeLit(a);
+          if (isLatch(Minisat::var(u)) 
+              && (t == 0 || u != a)) 
+            refine.push_back(Minisat::var(u));
+        }
+        delete slv;
+        rv = false;
+        break;
+      }
+      cex.push_back(IC3::Step());
+      values(concrete, *slv, concrete.beginInputs(), concrete.endInputs(), 
+             false, cex.back().inputs);
+      if (t == 0)
+        values(concrete, *slv, concrete.beginLatches(), 
+               concrete.endLatches(), false, cex.back().latches);
+      else
+        cex.back().latches = current;
+      if (w.size() > 1) {
+        current.clear();
+        values(concrete, *slv, concrete.beginLatches(), 
+               concrete.endLatches(), true, current);
+        if (last) {
+          cex.push_back(IC3::Step());
+          values(concrete, *slv, concrete.beginInputs(), 
+                 concrete.endInputs(), true, cex.back().inputs);
+          cex.back().latches = current;
+        }
+      }
+      delete slv;
+      if (last) break;
+    }
+    return rv;
+  }
+
+  IC3::Result check(aiger * aig, unsigned int propertyIndex, 
+                    const string & backend, const string & encoding, 
+                    const IC3::Options & options, IC3::Outcome * outcome) {
+    uint64_t start = nanotime();
+    if (outcome) *outcome = IC3::Outcome();
+    Model * concrete = modelFromAiger(aig, propertyIndex);
+    if (!concrete) return IC3::Unknown;
+    concrete->setSatBackend(backend);
+    concrete->setEncoding(encoding);
+
+    unsigned latches = aig->num_latches;
+    vector<bool> visible(latches, false);
+    support(aig, propertyIndex, visible);
+    vector<IC3::Lemma> kept;  // over the concrete model's latches
+    IC3::Outcome out;
+    IC3::Result rv = IC3::Unknown;
+    uint64_t queries = 0;
+    for (size_t refinements = 0; ; ++refinements) {
+      IC3::Options opts = options;
+      if (options.limits.seconds) {
+        opts.limits.seconds -= (nanotime() - start) / 1e9;
+        if (opts.limits.seconds <= 0) {
+          rv = IC3::Unknown;
+          break;
+        }
+      }
+      Map map;
+      aiger * abs = abstractAiger(aig, visible, map);
+      Model * model = modelFromAiger(abs, propertyIndex);
+      aiger_reset(abs);
+      model->setSatBackend(backend);
+      model->setEncoding(encoding);
+      vector<IC3::Lemma> frames(kept);
+      for (size_t i = 0; i < frames.size(); ++i)
+        frames[i].cube = mapLits(map.var, frames[i].cube);
+      opts.frames = &frames;
+      if (options.verbose)
+        cout << ". Abstraction:  " << refinements << " refinements, " 
+             << (model->endLatches() - model->beginLatches()) << " of " 
+             << latches << " latches visible, " << frames.size() 
+             << " lemmas restored" << endl;
+      rv = IC3::check(*model, opts, &out);
+      delete model;
+      queries += out.queries;
+      for (size_t i = 0; i < out.witness.size(); ++i) {
+        out.witness[i].inputs = mapLits(map.concrete, out.witness[i].inputs);
+        out.witness[i].latches = 
+          mapLits(map.concrete, out.witness[i].latches);
+      }
+      for (size_t i = 0; i < out.invariant.size(); ++i)
+        out.invariant[i] = mapLits(map.concrete, out.invariant[i]);
+      for (size_t i = 0; i < out.lemmas.size(); ++i)
+        out.lemmas[i].cube = mapLits(map.concrete, out.lemmas[i].cube);
+      if (rv != IC3::Unsafe) break;
+
+      vector<IC3::Step> cex;
+      vector<Minisat::Var> refine;
+      if (concretize(*concrete, out.witness, cex, refine)) {
+        out.witness = cex;
+        break;
+      }
+      size_t before = count(visible.begin(), visible.end(), true);
+      for (size_t i = 0; i < refine.size(); ++i)
+        visible[refine[i] - aig->num_inputs - 1] = true;
+      // should the conflict not name an invisible latch, fall back to
+      // the concrete model, where every counterexample is real
+      if ((size_t) count(visible.begin(), visible.end(), true) == before)
+        visible.assign(latches, true);
+      kept.swap(out.lemmas);
+    }
+    delete concrete;
+    if (outcome) {
+      *outcome = out;
+      outcome->result = rv;
+      if (rv != IC3::Unsafe) outcome->witness.clear();
+      outcome->queries = queries;
+      outcome->seconds = (nanotime() - start) / 1e9;
+    }
+    return rv;
+  }
+
+}
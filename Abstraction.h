@@ -0,0 +1,59 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef Abstraction_h_INCLUDED
+#define Abstraction_h_INCLUDED
+
+extern "C" {
+#include "aiger.h"
+}
+#include "IC3.h"
+
+// Localization abstraction: IC3 on a model in which most latches are
+// invisible, i.e., replaced by free inputs, so that frames and cubes
+// mention only the latches that the property has been found to need.
+// The abstract model has every behavior of the concrete one (and
+// more), so a proof on it is a proof.  A counterexample, though, may
+// be spurious; it is replayed on the concrete model, whose TR then
+// either confirms it or, at the first step at which it cannot follow
+// the counterexample, gives the invisible latches that it disagrees
+// on through the final conflict.  These become visible, and IC3
+// starts over on the refined model from the lemmas of the last run,
+// which remain valid in it.
+namespace Abstraction {
+
+  // Checks property propertyIndex of aig, which must be in the
+  // canonical AIGER order (inputs, latches, then ANDs), with Models
+  // of the given SAT backend and CNF encoding (see Model.h).  The
+  // wall-clock budget covers all refinements, the others apply to
+  // each IC3 run.  The outcome's witness, invariant, and lemmas are
+  // in the variables of the concrete model.  With options.verbose,
+  // prints the visible latches of each abstraction.
+  IC3::Result check(aiger * aig, unsigned int propertyIndex, 
+                    const string & backend, const string & encoding, 
+                    const IC3::Options & options, 
+                    IC3::Outcome * outcome = NULL);
+
+}
+
+#endif
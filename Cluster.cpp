@@ -0,0 +1,483 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <poll.h>
+#include <set>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include "Cluster.h"
+#include "IC3.h"
+#include "Model.h"
+
+namespace Cluster {
+
+  static bool isTCP(const string & address) {
+    return address.find(':') != string::npos 
+      && address.find('/') == string::npos;
+  }
+
+  // Opens a socket for address, then binds it (listen) or connects it;
+  // returns it, or -1.
+  static int openSocket(const string & address, bool listening) {
+    if (!isTCP(address)) {
+      struct sockaddr_un addr;
+      memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      if (address.size() >= sizeof(addr.sun_path)) return -1;
+      strcpy(addr.sun_path, address.c_str());
+      int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (fd < 0) return -1;
+      if (listening) unlink(address.c_str());
+      int rv = listening 
+        ? bind(fd, (struct sockaddr *) &addr, sizeof(addr)) || listen(fd, 64)
+        : connect(fd, (struct sockaddr *) &addr, sizeof(addr));
+      if (rv) {
+        close(fd);
+        return -1;
+      }
+      return fd;
+    }
+    size_t colon = address.rfind(':');
+    string host = address.substr(0, colon), port = address.substr(colon+1);
+    struct addrinfo hints, * res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (listening) hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(), 
+                    &hints, &res))
+      return -1;
+    int fd = -1;
+    for (struct addrinfo * ai = res; ai && fd < 0; ai = ai->ai_next) {
+      fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (fd < 0) continue;
+      int one = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      int rv = listening 
+        ? bind(fd, ai->ai_addr, ai->ai_addrlen) || listen(fd, 64)
+        : connect(fd, ai->ai_addr, ai->ai_addrlen);
+      if (rv) {
+        close(fd);
+        fd = -1;
+      }
+    }
+    freeaddrinfo(res);
+    return fd;
+  }
+
+  static bool sendAll(int fd, const char * data, size_t size) {
+    size_t off = 0;
+    while (off < size) {
+      ssize_t n = send(fd, data + off, size - off, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      off += (size_t) n;
+    }
+    return true;
+  }
+
+  static bool sendLine(int fd, const string & line) {
+    string buf = line + "\n";
+    return sendAll(fd, buf.data(), buf.size());
+  }
+
+  // Reads up to and including the next newline into buf; returns
+  // false at the end of the connection.
+  static bool readLine(int fd, string & buf, string & line) {
+    char chunk[4096];
+    size_t nl;
+    while ((nl = buf.find('\n')) == string::npos) {
+      ssize_t n = read(fd, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      buf.append(chunk, (size_t) n);
+    }
+    line = buf.substr(0, nl);
+    buf.erase(0, nl+1);
+    return true;
+  }
+
+  static string lineOfLemma(const IC3::Lemma & lemma) {
+    stringstream ss;
+    ss << "lemma " << lemma.level;
+    for (LitVec::const_iterator i = lemma.cube.begin(); 
+         i != lemma.cube.end(); ++i)
+      ss << " " << Minisat::toInt(*i);
+    return ss.str();
+  }
+
+  // Parses a lemma line into lemma.  Its literals must be of latches,
+  // whose variables are [first, last), since a literal from a worker
+  // with another model would crash the check.
+  static bool lemmaOfLine(const string & line, size_t first, size_t last,
+                          IC3::Lemma & lemma) {
+    istringstream ss(line);
+    string tag;
+    if (!(ss >> tag >> lemma.level) || tag != "lemma") return false;
+    lemma.cube.clear();
+    int lit;
+    while (ss >> lit) {
+      if (lit < 0) return false;
+      Minisat::Lit l = Minisat::toLit(lit);
+      size_t v = (size_t) Minisat::var(l);
+      if (v < first || v >= last) return false;
+      lemma.cube.push_back(l);
+    }
+    return !lemma.cube.empty();
+  }
+
+  // The worker's end of the lemma exchange: the check publishes on
+  // its own thread, while a reader thread queues incoming lemmas and
+  // cancels the check when the coordinator stops it or goes away.
+  class SocketPort : public IC3::LemmaPort {
+  public:
+    SocketPort(int _fd, const Model & model, IC3::CancelToken & _cancel) 
+      : fd(_fd), first(model.beginLatches()->index()), 
+        last(first + (model.endLatches() - model.beginLatches())), 
+        cancel(_cancel), connected(true) {}
+
+    void publish(const IC3::Lemma & lemma) {
+      if (connected) connected = sendLine(fd, lineOfLemma(lemma));
+    }
+    void receive(vector<IC3::Lemma> & lemmas) {
+      lock_guard<mutex> lock(mtx);
+      lemmas.insert(lemmas.end(), inbox.begin(), inbox.end());
+      inbox.clear();
+    }
+
+    void start(const string & pending) {
+      reader = thread([this, pending]() {
+        string buf = pending, line;
+        IC3::Lemma lemma;
+        while (readLine(fd, buf, line)) {
+          if (line == "stop") break;
+          if (lemmaOfLine(line, first, last, lemma)) {
+            lock_guard<mutex> lock(mtx);
+            inbox.push_back(lemma);
+          }
+        }
+        cancel.cancel();
+      });
+    }
+    void finish() {
+      shutdown(fd, SHUT_RDWR);
+      reader.join();
+    }
+
+  private:
+    int fd;
+    size_t first, last;
+    IC3::CancelToken & cancel;
+    bool connected;
+    thread reader;
+    mutex mtx;
+    vector<IC3::Lemma> inbox;
+  };
+
+  int work(const string & address, const Service::Job & job, 
+           unsigned int seed, int verbose, ostream * json) {
+    int fd = -1;
+    for (size_t tries = 0; tries < 100 && fd < 0; ++tries) {
+      if (tries) this_thread::sleep_for(chrono::milliseconds(100));
+      fd = openSocket(address, false);
+    }
+    if (fd < 0) {
+      cout << "cannot connect to " << address << endl;
+      return IC3::Unknown;
+    }
+
+    // receive the model
+    string buf, line;
+    istringstream header;
+    string tag;
+    unsigned int property;
+    size_t size;
+    if (!readLine(fd, buf, line)) {
+      close(fd);
+      return IC3::Unknown;
+    }
+    header.str(line);
+    if (!(header >> tag >> property >> size) || tag != "model") {
+      cout << "bad model header from " << address << endl;
+      close(fd);
+      return IC3::Unknown;
+    }
+    char chunk[4096];
+    while (buf.size() < size) {
+      ssize_t n = read(fd, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        close(fd);
+        return IC3::Unknown;
+      }
+      buf.append(chunk, (size_t) n);
+    }
+    aiger * aig = aiger_init();
+    FILE * in = fmemopen((void *) buf.data(), size, "r");
+    const char * msg = in ? aiger_read_from_file(aig, in) : "fmemopen failed";
+    if (in) fclose(in);
+    buf.erase(0, size);
+    Model * model = msg ? NULL : modelFromAiger(aig, property);
+    if (msg) cout << msg << endl;
+    aiger_reset(aig);
+    if (!model) {
+      close(fd);
+      return IC3::Unknown;
+    }
+    model->setSatBackend(job.backend);
+    model->setEncoding(job.encoding);
+
+    IC3::CancelToken cancel;
+    SocketPort port(fd, *model, cancel);
+    port.start(buf);
+    IC3::Options opts = job.options();
+    opts.verbose = verbose;
+    opts.json = json;
+    if (seed) {
+      opts.random = true;
+      opts.seed = seed;
+    }
+    opts.lemmas = &port;
+    opts.cancel = &cancel;
+    IC3::Outcome outcome;
+    IC3::Result rv = IC3::check(*model, opts, &outcome);
+    stringstream ss;
+    ss << "result " << rv << " " << outcome.k;
+    sendLine(fd, ss.str());
+    port.finish();
+    close(fd);
+    delete model;
+    return rv;
+  }
+
+  // The command line of a local worker.
+  static vector<string> workerArgs(const string & program, 
+                                   const string & address, 
+                                   const Service::Job & job, 
+                                   unsigned int seed) {
+    vector<string> args;
+    args.push_back(program);
+    args.push_back("-worker");
+    args.push_back(address);
+    if (job.basic) args.push_back("-b");
+    if (job.adaptive) args.push_back("-a");
+    if (job.share) args.push_back("-share");
+    if (job.ternary) args.push_back("-t");
+    stringstream ss;
+    if (job.limits.seconds) {
+      ss << job.limits.seconds;
+      args.push_back("-T");
+      args.push_back(ss.str());
+    }
+    if (job.limits.conflicts) {
+      ss.str("");
+      ss << job.limits.conflicts;
+      args.push_back("-C");
+      args.push_back(ss.str());
+    }
+    if (job.limits.memoryMB) {
+      ss.str("");
+      ss << job.limits.memoryMB;
+      args.push_back("-M");
+      args.push_back(ss.str());
+    }
+    args.push_back("-sat");
+    args.push_back(job.backend);
+    args.push_back("-cnf");
+    args.push_back(job.encoding);
+    if (seed) {
+      ss.str("");
+      ss << seed;
+      args.push_back("-seed");
+      args.push_back(ss.str());
+    }
+    return args;
+  }
+
+  int coordinate(aiger * aig, const Service::Job & job, 
+                 const string & address, size_t spawn, 
+                 const string & program, bool verbose) {
+    // the model as sent to each worker
+    char * data = NULL;
+    size_t size = 0;
+    FILE * out = open_memstream(&data, &size);
+    if (!out || !aiger_write_to_file(aig, aiger_binary_mode, out)) {
+      if (out) fclose(out);
+      free(data);
+      cout << "cannot encode the model" << endl;
+      return IC3::Unknown;
+    }
+    fclose(out);
+    stringstream ss;
+    ss << "model " << job.property << " " << size << "\n";
+    string model = ss.str() + string(data, size);
+    free(data);
+
+    int sock = openSocket(address, true);
+    if (sock < 0) {
+      cout << "cannot listen on " << address << endl;
+      return IC3::Unknown;
+    }
+
+    vector<pid_t> children;
+    for (size_t i = 0; i < spawn; ++i) {
+      vector<string> args = workerArgs(program, address, job, i);
+      pid_t pid = fork();
+      if (pid == 0) {
+        close(sock);
+        // the coordinator reports for the workers
+        if (!freopen("/dev/null", "w", stdout)) _exit(1);
+        vector<char *> argv;
+        for (size_t j = 0; j < args.size(); ++j) 
+          argv.push_back(const_cast<char *>(args[j].c_str()));
+        argv.push_back(NULL);
+        execvp(program.c_str(), &argv[0]);
+        _exit(1);
+      }
+      if (pid > 0) children.push_back(pid);
+    }
+    size_t live = children.size();
+
+    struct Worker {
+      int fd;
+      size_t id;
+      string buf;
+    };
+    vector<Worker> workers;
+    vector<string> log;  // of distinct lemmas, for workers joining late
+    set<string> seen;
+    size_t joined = 0, received = 0;
+    int rv = IC3::Unknown;
+    bool stop = false;
+    while (!stop) {
+      if (workers.empty() && (spawn ? live == 0 : joined > 0)) break;
+      vector<struct pollfd> fds(workers.size() + 1);
+      fds[0].fd = sock;
+      fds[0].events = POLLIN;
+      for (size_t i = 0; i < workers.size(); ++i) {
+        fds[i+1].fd = workers[i].fd;
+        fds[i+1].events = POLLIN;
+      }
+      int n = poll(&fds[0], fds.size(), 200);
+      for (size_t i = 0; i < children.size(); ++i)
+        if (children[i] && waitpid(children[i], NULL, WNOHANG) > 0) {
+          children[i] = 0;
+          --live;
+        }
+      if (n < 0 && errno != EINTR) break;
+      if (n <= 0) continue;
+
+      vector<bool> gone(workers.size(), false);
+      for (size_t i = 0; i < workers.size() && !stop; ++i) {
+        if (gone[i] || !(fds[i+1].revents & (POLLIN | POLLHUP | POLLERR)))
+          continue;
+        Worker & w = workers[i];
+        char chunk[4096];
+        ssize_t r = read(w.fd, chunk, sizeof(chunk));
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+          gone[i] = true;
+          continue;
+        }
+        w.buf.append(chunk, (size_t) r);
+        size_t nl;
+        while (!gone[i] && (nl = w.buf.find('\n')) != string::npos) {
+          string line = w.buf.substr(0, nl);
+          w.buf.erase(0, nl+1);
+          if (line.compare(0, 6, "lemma ") == 0) {
+            ++received;
+            if (!seen.insert(line).second) continue;
+            log.push_back(line);
+            for (size_t j = 0; j < workers.size(); ++j)
+              if (j != i && !gone[j] && !sendLine(workers[j].fd, line))
+                gone[j] = true;
+          }
+          else if (line.compare(0, 7, "result ") == 0) {
+            istringstream rs(line.substr(7));
+            int result = IC3::Unknown;
+            size_t k = 0;
+            rs >> result >> k;
+            if (verbose)
+              cout << "worker " << w.id << ": " << result << " K=" << k 
+                   << endl;
+            if (result == IC3::Safe || result == IC3::Unsafe) {
+              rv = result;
+              stop = true;
+              break;
+            }
+            gone[i] = true;
+          }
+        }
+      }
+      for (size_t i = workers.size(); i-- > 0; )
+        if (gone[i]) {
+          close(workers[i].fd);
+          workers.erase(workers.begin() + i);
+        }
+
+      if (!stop && (fds[0].revents & POLLIN)) {
+        int fd = accept(sock, NULL, NULL);
+        if (fd >= 0) {
+          bool ok = sendAll(fd, model.data(), model.size());
+          for (size_t i = 0; ok && i < log.size(); ++i)
+            ok = sendLine(fd, log[i]);
+          if (ok) {
+            Worker w;
+            w.fd = fd;
+            w.id = joined++;
+            workers.push_back(w);
+          }
+          else
+            close(fd);
+        }
+      }
+    }
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+      sendLine(workers[i].fd, "stop");
+      close(workers[i].fd);
+    }
+    close(sock);
+    if (!isTCP(address)) unlink(address.c_str());
+    for (size_t i = 0; i < children.size(); ++i)
+      if (children[i]) waitpid(children[i], NULL, 0);
+    if (verbose)
+      cout << ". Workers:      " << joined << endl
+           << ". Lemmas:       " << log.size() << " of " << received 
+           << " received relayed" << endl;
+    return rv;
+  }
+
+}
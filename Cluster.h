@@ -0,0 +1,77 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef Cluster_h_INCLUDED
+#define Cluster_h_INCLUDED
+
+extern "C" {
+#include "aiger.h"
+}
+#include "Service.h"
+
+// A check spread over worker processes, possibly on other machines,
+// that exchange lemmas through a coordinator.  Each worker runs its
+// own IC3 on the whole model, so workers that differ in options or
+// seed explore differently; a lemma one learns is offered to the
+// others, which add it only if it is inductive relative to their own
+// frames (see IC3::LemmaPort).  The first verdict stops everyone.
+//
+// The coordinator and the workers speak lines over a stream socket,
+// which is TCP for an address "<host>:<port>" (an empty host listens
+// on all interfaces) and a Unix domain socket for any other address:
+//
+//   coordinator to worker:  model <property ID> <bytes>, followed by
+//                           the model in binary AIGER;
+//                           lemma <level> <literal>...;
+//                           stop
+//   worker to coordinator:  lemma <level> <literal>...;
+//                           result <0|1|2> <K>
+//
+// where a literal is a Minisat literal index into the Model that
+// modelFromAiger() builds, which is the same in every worker.
+namespace Cluster {
+
+  // Serves the property of aig to the workers that connect to
+  // address, relaying each lemma to all other workers, including to
+  // those joining later.  With spawn > 0, first starts that many
+  // local workers by running program (this binary) with the options
+  // of job, the first with the default deterministic run and the
+  // others randomized with seeds 1, 2, ....  Returns the first
+  // verdict, or Unknown once every worker has finished without one.
+  // With verbose, prints each worker's result and the number of
+  // lemmas relayed.
+  int coordinate(aiger * aig, const Service::Job & job, 
+                 const string & address, size_t spawn, 
+                 const string & program, bool verbose);
+
+  // Runs a worker for the coordinator at address, with the options of
+  // job and, if seed is nonzero, randomized with it; retries
+  // connecting for a while so that workers can start first.  Returns
+  // its own verdict, which is Unknown if another worker's stopped it.
+  // Statistics go to stdout with verbose and to json if given.
+  int work(const string & address, const Service::Job & job, 
+           unsigned int seed, int verbose, ostream * json);
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef Cube_h_INCLUDED
+#define Cube_h_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+
+#include "Model.h"
+
+// A dense, latch-indexed representation of cubes: bit 2i (2i+1) is
+// set if latch i appears positively (negatively).  Sorted LitVecs
+// remain the primary representation; a DenseCube pays off for
+// membership tests against large cubes.  (Bulk operations, such as
+// a subset test, would need both cubes dense, while the cubes tested
+// against one, e.g., lemmas, are mostly short.)
+class DenseCube {
+public:
+  DenseCube() : base(0) {}
+  // For cubes over the latches of model.
+  DenseCube(const Model & model) : 
+    base(2 * model.beginLatches()->var()),
+    words(((size_t) (model.endLatches() - model.beginLatches()) * 2 + 63) 
+          / 64, 0) {}
+
+  // Sets the bits of cube's literals; assumes they were all clear.
+  void assign(const LitVec & cube) {
+    for (LitVec::const_iterator i = cube.begin(); i != cube.end(); ++i)
+      set(*i);
+  }
+  // Empties a DenseCube that holds exactly cube's literals, which is
+  // cheaper than clear() for small cubes.
+  void reset(const LitVec & cube) {
+    for (LitVec::const_iterator i = cube.begin(); i != cube.end(); ++i)
+      words[index(*i) >> 6] = 0;
+  }
+  void clear() { words.assign(words.size(), 0); }
+
+  void set(Minisat::Lit lit) { 
+    size_t i = index(lit); 
+    words[i >> 6] |= (uint64_t) 1 << (i & 63); 
+  }
+  bool has(Minisat::Lit lit) const { 
+    size_t i = index(lit); 
+    return (words[i >> 6] >> (i & 63)) & 1; 
+  }
+
+private:
+  size_t index(Minisat::Lit lit) const { 
+    assert ((size_t) Minisat::toInt(lit) >= base);
+    return (size_t) Minisat::toInt(lit) - base; 
+  }
+
+  size_t base;             // index of the first latch's positive literal
+  vector<uint64_t> words;
+};
+
+#endif
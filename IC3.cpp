@@ -22,12 +22,23 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 *********************************************************************/
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <set>
-#include <sys/times.h>
+#include <sys/resource.h>
+#include <thread>
 
+#include "Cube.h"
 #include "IC3.h"
-#include "Solver.h"
+#include "Perf.h"
+#include "SatSolver.h"
+#include "Stats.h"
+#include "Trace.h"
 #include "Vec.h"
 
 // A reference implementation of IC3, i.e., one that is meant to be
@@ -59,7 +70,9 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //    In particular, if s with inputs i is a predecessor of t, then s
 //    & i & T & ~t' is unsatisfiable, where T is the transition
 //    relation.  The unsat core reveals a suitable lifting of s.  See
-//    stateOf().
+//    stateOf().  Optionally, a cheaper ternary simulation that sets
+//    latches of s to X one by one is tried first, as in the FMCAD'11
+//    paper.  See ternaryLift().
 //
 //  o One solver per frame, which various authors of IC3
 //    implementations have tried (including me in pre-publication
@@ -131,16 +144,39 @@ namespace IC3 {
   class IC3 {
   public:
     IC3(Model & _model) :
-      verbose(0), random(false), model(_model), k(1), nextState(0),
-      litOrder(), slimLitOrder(),
-      numLits(0), numUpdates(0), maxDepth(1), maxCTGs(3),
-      maxJoins(1<<20), micAttempts(3), cexState(0), nQuery(0), nCTI(0), nCTG(0),
-      nmic(0), satTime(0), nCoreReduced(0), nAbortJoin(0), nAbortMic(0)
+      proofLevel(0), verbose(0), random(false), seed(0), model(_model), k(1),
+      nextState(0), litOrder(), slimLitOrder(),
+      numLits(0), numUpdates(0), nConflicts(0), cancel(NULL), watching(false),
+      timeUp(false), stopping(false), running(NULL), share(false),
+      shareMaxSize(8), nShareOffered(0), nShareRejected(0), nShareImports(0),
+      nShareUsed(0), nGenLookups(0), nGenProven(0), nGenSubsumed(0),
+      nGenFailing(0), maxDepth(1), maxCTGs(3), maxJoins(1<<20),
+      micAttempts(3), basic(false), ternary(false), liftRatio(0.75), scratch(_model),
+      cexState(0), obligationPort(NULL), port(NULL), importing(false),
+      nLemmasSent(0), nLemmasReceived(0), nLemmasImported(0),
+      adaptive(false), adaptMoves(0), adaptUndos(0), lastKnob(NKnobs),
+      lastDir(0), tabuKnob(NKnobs), tabuDir(0), nextKnob(0), lastScore(0),
+      nQuery(0), nCTI(0), nCTG(0), nCTGTry(0), nJoin(0), nmic(0),
+      startTime(time()), satTime(0), nCoreReduced(0), nAbortJoin(0),
+      nAbortMic(0), nPushSkipped(0),
+      nSatLift(0), nTernaryLift(0), nTernaryFallback(0), satLiftLits(0), 
+      ternaryLits(0), satLiftTime(0), ternaryTime(0), qtype(QFrontier),
+      json(NULL), jsonPerLevel(false), trace(NULL)
     {
       slimLitOrder.heuristicLitOrder = &litOrder;
+      for (int p = 0; p < NPhases; ++p)
+        phaseTime[p] = phaseCalls[p] = phaseDepth[p] = 0;
+#ifdef IC3_PERF
+      for (int p = 0; p < NPhases; ++p)
+        for (int c = 0; c < PerfCounters::NCounters; ++c)
+          phasePerf[p][c] = 0;
+#endif
+      for (int q = 0; q < NQueryTypes; ++q)
+        queryProps[q] = queryReused[q] = 0;
 
       // construct lifting solver
       lifts = model.newSolver();
+      modelVars = lifts->nVars();
       // don't assert primed invariant constraints
       model.loadTransitionRelation(*lifts, false);
       // assert notInvConstraints (in stateOf) when lifting
@@ -150,9 +186,10 @@ namespace IC3 {
       for (LitVec::const_iterator i = model.invariantConstraints().begin();
            i != model.invariantConstraints().end(); ++i)
         cls.push(model.primeLit(~*i));
-      lifts->addClause_(cls);
+      lifts->addClause(cls);
     }
     ~IC3() {
+      stopWatchdog();
       for (vector<Frame>::const_iterator i = frames.begin(); 
            i != frames.end(); ++i)
         if (i->consecution) delete i->consecution;
@@ -161,13 +198,18 @@ namespace IC3 {
 
     // The main loop.
     bool check() {
-      startTime = time();  // stats
       while (true) {
         if (verbose > 1) cout << "Level " << k << endl;
+        event(Trace::Level, k);
+        checkBudgets(true);
         extend();                         // push frontier frame
+        if (port) importLemmas();         // lemmas of other checks
         if (!strengthen()) return false;  // strengthen to remove bad successors
         if (propagate()) return true;     // propagate clauses; check for proof
+        if (adaptive) adapt();            // retune generalization
         printStats();
+        if (json && jsonPerLevel) writeJson(*json, "running");
+        if (progress) reportProgress();
         ++k;                              // increment frontier
       }
     }
@@ -184,10 +226,88 @@ namespace IC3 {
       }
     }
 
+    // The same chain, for check()'s caller, ending in the step that
+    // violates the property, whose latches follow from the last state.
+    void witness(vector<Step> & steps) { chain(cexState, steps); }
+
+    // ... or that of any state.
+    void chain(size_t st, vector<Step> & steps) {
+      size_t last = 0;
+      for (size_t curr = st; curr; curr = state(curr).successor) {
+        steps.push_back(Step());
+        steps.back().inputs = state(curr).inputs;
+        steps.back().latches = state(curr).latches;
+        last = curr;
+      }
+      if (last) {
+        steps.push_back(Step());
+        steps.back().inputs = state(last).badInputs;
+      }
+    }
+
+    // Frames 1 and up, for Outcome::lemmas or for a later check to
+    // start from (see restore()).
+    void lemmas(vector<Lemma> & out) {
+      for (size_t i = 1; i < frames.size(); ++i)
+        for (CubeSet::const_iterator j = frames[i].borderCubes.begin(); 
+             j != frames[i].borderCubes.end(); ++j) {
+          out.push_back(Lemma());
+          out.back().level = i;
+          out.back().cube = *j;
+        }
+    }
+
+    // Starts from the lemmas of an earlier check (see
+    // Options::frames), each in its frame, at the frontier below the
+    // highest of them: its frames are frames here, too, since this
+    // model has no initial states or transitions that the other's
+    // lacks.
+    void restore(const vector<Lemma> & lemmas) {
+      size_t top = 0;
+      for (vector<Lemma>::const_iterator i = lemmas.begin(); 
+           i != lemmas.end(); ++i)
+        top = max(top, i->level);
+      k = max(k, top > 0 ? top - 1 : 0);
+      extend();
+      for (vector<Lemma>::const_iterator i = lemmas.begin(); 
+           i != lemmas.end(); ++i) {
+        if (i->level == 0 || i->cube.empty()) continue;
+        LitVec cube = i->cube;
+        addCube(i->level, cube);
+      }
+    }
+
+    // After a proof, the frame that propagate() emptied is equal to
+    // the next one, which is therefore inductive; each cube is kept in
+    // only one frame, so it consists of the cubes of the frames above.
+    void invariant(vector<LitVec> & cubes) {
+      for (size_t i = proofLevel + 1; i < frames.size(); ++i)
+        cubes.insert(cubes.end(), frames[i].borderCubes.begin(), 
+                     frames[i].borderCubes.end());
+    }
+
   private:
 
+    size_t proofLevel;  // frame emptied by propagate(), after a proof
+
+    function<void (const Progress &)> progress;
+    void reportProgress() {
+      Progress p;
+      p.k = k;
+      p.seconds = (time() - startTime) / 1e9;
+      p.queries = nQuery;
+      p.conflicts = nConflicts;
+      p.ctis = nCTI;
+      p.ctgs = nCTG;
+      for (size_t i = 1; i < frames.size(); ++i)
+        p.lemmas.push_back(frames[i].borderCubes.size());
+      progress(p);
+    }
+
     int verbose; // 0: silent, 1: stats, 2: all
     bool random;
+    unsigned int seed;  // for random runs; per instance, for reentrancy
+    int nextRandom() { return rand_r(&seed); }
 
     string stringOfLitVec(const LitVec & vec) {
       stringstream ss;
@@ -207,6 +327,7 @@ namespace IC3 {
       size_t successor;  // successor State
       LitVec latches;
       LitVec inputs;
+      LitVec badInputs;  // without a successor: inputs of the violation
       size_t index;      // for pool
       bool used;         // for pool
     };
@@ -232,6 +353,7 @@ namespace IC3 {
       st.used = false;
       st.latches.clear();
       st.inputs.clear();
+      st.badInputs.clear();
       if (nextState > st.index-1) nextState = st.index-1;
     }
     void resetStates() {
@@ -239,6 +361,7 @@ namespace IC3 {
         i->used = false;
         i->latches.clear();
         i->inputs.clear();
+        i->badInputs.clear();
       }
       nextState = 0;
     }
@@ -267,6 +390,7 @@ namespace IC3 {
       }
     };
     typedef set<LitVec, LitVecComp> CubeSet;
+    typedef map<LitVec, uint64_t, LitVecComp> CubeEpochs;
 
     // A proof obligation.
     struct Obligation {
@@ -293,11 +417,13 @@ namespace IC3 {
     struct Frame {
       size_t k;             // steps from initial state
       CubeSet borderCubes;  // additional cubes in this and previous frames
-      Minisat::Solver * consecution;
+      SatSolver * consecution;
+      uint64_t epoch;       // bumped whenever consecution gains a lemma
+      CubeEpochs pushFailed;  // epoch at which each cube last failed to push
     };
     vector<Frame> frames;
 
-    Minisat::Solver * lifts;
+    SatSolver * lifts;
     Minisat::Lit notInvConstraints;
 
     // Push a new Frame.
@@ -306,10 +432,10 @@ namespace IC3 {
         frames.resize(frames.size()+1);
         Frame & fr = frames.back();
         fr.k = frames.size()-1;
+        fr.epoch = 0;
         fr.consecution = model.newSolver();
         if (random) {
-          fr.consecution->random_seed = rand();
-          fr.consecution->rnd_init_act = true;
+          fr.consecution->randomize(nextRandom());
         }
         if (fr.k == 0) model.loadInitialCondition(*fr.consecution);
         model.loadTransitionRelation(*fr.consecution);
@@ -376,73 +502,333 @@ namespace IC3 {
       if (rev) reverse(cube + start, cube + cube.size());
     }
 
+    // Thrown when a budget runs out or the check is cancelled; unwinds
+    // to check().
+    struct OutOfBudget {
+      OutOfBudget(const char * _what) : what(_what) {}
+      const char * what;
+    };
+
+    Limits limits;
+    uint64_t nConflicts;  // over all solvers, for the conflict budget
+    CancelToken * cancel;
+
+    // The wall-clock budget is enforced between queries and, through a
+    // watchdog thread that interrupts the running solver, within them.
+    bool watching, timeUp, stopping;
+    SatSolver * running;
+    chrono::steady_clock::time_point deadline;
+    mutex budgetMutex;
+    condition_variable budgetCV;
+    thread watchdog;
+
+    void startWatchdog() {
+      if (limits.seconds <= 0) return;
+      watching = true;
+      deadline = chrono::steady_clock::now() 
+        + chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>(limits.seconds));
+      watchdog = thread(&IC3::watch, this);
+    }
+    void watch() {
+      unique_lock<mutex> lock(budgetMutex);
+      while (!stopping)
+        if (budgetCV.wait_until(lock, deadline) == cv_status::timeout) {
+          timeUp = true;
+          if (running) running->interrupt();
+          return;
+        }
+    }
+    void stopWatchdog() {
+      if (!watching) return;
+      {
+        lock_guard<mutex> lock(budgetMutex);
+        stopping = true;
+      }
+      budgetCV.notify_one();
+      watchdog.join();
+      watching = false;
+    }
+
+    // Resident set size in MB, from /proc.
+    static size_t residentMB() {
+      ifstream statm("/proc/self/statm");
+      size_t pages = 0, resident = 0;
+      statm >> pages >> resident;
+      return resident * (size_t) sysconf(_SC_PAGESIZE) >> 20;
+    }
+
+    // Called between queries, and with level at the start of each
+    // level; throws if a budget has run out.
+    void checkBudgets(bool level = false) {
+      if (watching) {
+        lock_guard<mutex> lock(budgetMutex);
+        if (timeUp) throw OutOfBudget("time");
+      }
+      if (limits.conflicts && nConflicts >= limits.conflicts)
+        throw OutOfBudget("conflicts");
+      if (cancel && cancel->cancelled())
+        throw OutOfBudget("cancel");
+      // reading /proc is comparatively expensive
+      if (limits.memoryMB && (level || nQuery % 128 == 0)
+          && residentMB() >= limits.memoryMB)
+        throw OutOfBudget("memory");
+    }
+
+    // All SAT queries of the main loop go through here.
+    bool solve(SatSolver & slv, const MSLitVec & assumps) {
+      checkBudgets();
+      // base cases are not of the frames' TR
+      if (share && qtype != QBase) importShared(slv);
+      if (cancel && !cancel->attach(&slv)) throw OutOfBudget("cancel");
+      slv.setConfBudget(limits.conflicts 
+                        ? (int64_t) (limits.conflicts - nConflicts) : -1);
+      if (watching) {
+        // Under the lock, so that either the watchdog sees the solver
+        // or the query sees that the time is up.
+        lock_guard<mutex> lock(budgetMutex);
+        if (timeUp) {
+          if (cancel) cancel->detach(&slv);
+          throw OutOfBudget("time");
+        }
+        running = &slv;
+      }
+      uint64_t conflicts = slv.conflicts(), props = slv.propagations(),
+        reused = slv.reusedAssignments();
+      ++nQuery; startTimer();  // stats
+      Minisat::lbool rv = slv.solve(assumps);
+      uint64_t ns = time() - timer;
+      satTime += ns;
+      queryLatency[qtype].add(ns);
+      ++levelStat(k).queries;
+      nConflicts += slv.conflicts() - conflicts;
+      queryProps[qtype] += slv.propagations() - props;
+      queryReused[qtype] += slv.reusedAssignments() - reused;
+      event(Trace::SatCall, qtype, (uint32_t) min(ns, (uint64_t) UINT32_MAX),
+            rv == Minisat::l_True);
+      if (cancel) cancel->detach(&slv);
+      if (watching) {
+        lock_guard<mutex> lock(budgetMutex);
+        running = NULL;
+      }
+      if (rv == Minisat::l_Undef) {
+        checkBudgets();
+        throw OutOfBudget("conflicts");
+      }
+      if (share && &slv != lifts && qtype != QBase) exportLearnts(slv);
+      return rv == Minisat::l_True;
+    }
+
+    // Sharing of learned clauses (-share).  Every frame's solver holds
+    // the same TR, so each re-derives the same facts about it.  Every
+    // shareInterval conflicts of a frame's solver, its short learned
+    // clauses over the Model's variables (so none mentions an
+    // activation literal) are offered to the others.  Only clauses that
+    // the lifting solver, which holds just the TR, confirms within a
+    // small conflict budget are shared: the rest may rest on frame
+    // lemmas or the initial condition.  A solver imports the shared
+    // clauses that are new to it before its next query, as learned
+    // clauses that it deletes again if they go unused.  An import that
+    // later takes part in a conflict is counted as used.
+    bool share;
+    size_t shareMaxSize;                  // longest clause shared
+    static const uint64_t shareInterval = 100;
+    static const int64_t shareCheckConflicts = 100;
+    static const size_t shareMaxOffered = 1 << 16;
+    Minisat::Var modelVars;               // variables of the Model
+    struct Shared {
+      LitVec cls;
+      SatSolver * origin;
+    };
+    vector<Shared> shared;
+    set<LitVec> offered;                  // shared and rejected clauses
+    struct ShareState {
+      ShareState() : imported(0), exportedAt(0) {}
+      size_t imported;                    // prefix of shared imported
+      uint64_t exportedAt;                // conflicts at the last export
+      set<LitVec> unused;                 // imports not yet in a conflict
+    };
+    map<SatSolver *, ShareState> shareStates;
+    uint64_t nShareOffered, nShareRejected, nShareImports, nShareUsed;
+
+    void importShared(SatSolver & slv) {
+      ShareState & ss = shareStates[&slv];
+      for (; ss.imported < shared.size(); ++ss.imported) {
+        const Shared & sh = shared[ss.imported];
+        if (sh.origin == &slv) continue;
+        MSLitVec cls;
+        for (LitVec::const_iterator i = sh.cls.begin(); i != sh.cls.end(); 
+             ++i)
+          cls.push(*i);
+        slv.addLearnt(cls);
+        ss.unused.insert(sh.cls);
+        ++nShareImports;
+      }
+    }
+
+    void exportLearnts(SatSolver & slv) {
+      ShareState & ss = shareStates[&slv];
+      if (slv.conflicts() - ss.exportedAt < shareInterval) return;
+      ss.exportedAt = slv.conflicts();
+      vector<SatSolver::Learnt> learnts;
+      slv.learnts(shareMaxSize, modelVars, learnts);
+      for (vector<SatSolver::Learnt>::iterator i = learnts.begin(); 
+           i != learnts.end(); ++i) {
+        sort(i->lits.begin(), i->lits.end());
+        if (i->activity == 0) continue;  // an unused import
+        if (ss.unused.erase(i->lits)) {
+          ++nShareUsed;
+          continue;
+        }
+        if (offered.size() >= shareMaxOffered 
+            || !offered.insert(i->lits).second)
+          continue;
+        ++nShareOffered;
+        if (!impliedByTR(i->lits)) {
+          ++nShareRejected;
+          continue;
+        }
+        shared.push_back(Shared());
+        shared.back().cls = i->lits;
+        shared.back().origin = &slv;
+      }
+    }
+
+    bool impliedByTR(const LitVec & cls) {
+      MSLitVec assumps;
+      for (LitVec::const_iterator i = cls.begin(); i != cls.end(); ++i)
+        assumps.push(~*i);
+      uint64_t conflicts = lifts->conflicts();
+      lifts->setConfBudget(shareCheckConflicts);
+      Minisat::lbool rv = lifts->solve(assumps);
+      nConflicts += lifts->conflicts() - conflicts;
+      return rv == Minisat::l_False;
+    }
+
     // Assumes that last call to fr.consecution->solve() was
     // satisfiable.  Extracts state(s) cube from satisfying
     // assignment.
     size_t stateOf(Frame & fr, size_t succ = 0) {
+      PhaseTimer pt(*this, PLift);  // stats
       // create state
       size_t st = newState();
       state(st).successor = succ;
-      MSLitVec assumps;
-      assumps.capacity(1 + 2 * (model.endInputs()-model.beginInputs())
-                       + (model.endLatches()-model.beginLatches()));
-      Minisat::Lit act = Minisat::mkLit(lifts->newVar());  // activation literal
-      assumps.push(act);
-      Minisat::vec<Minisat::Lit> cls;
-      cls.push(~act);
-      cls.push(notInvConstraints);  // successor must satisfy inv. constraint
-      if (succ == 0)
-        cls.push(~model.primedError());
-      else
-        for (LitVec::const_iterator i = state(succ).latches.begin(); 
-             i != state(succ).latches.end(); ++i)
-          cls.push(model.primeLit(~*i));
-      lifts->addClause_(cls);
-      // extract and assert primary inputs
+      // extract primary inputs
       for (VarVec::const_iterator i = model.beginInputs(); 
            i != model.endInputs(); ++i) {
         Minisat::lbool val = fr.consecution->modelValue(i->var());
-        if (val != Minisat::l_Undef) {
-          Minisat::Lit pi = i->lit(val == Minisat::l_False);
-          state(st).inputs.push_back(pi);  // record full inputs
-          assumps.push(pi);
-        }
+        if (val != Minisat::l_Undef)
+          state(st).inputs.push_back(i->lit(val == Minisat::l_False));  // record full inputs
       }
-      // some properties include inputs, so assert primed inputs after        
+      // some properties include inputs, so extract primed inputs too
+      LitVec pinputs;
       for (VarVec::const_iterator i = model.beginInputs(); 
            i != model.endInputs(); ++i) {
         Minisat::lbool pval = 
           fr.consecution->modelValue(model.primeVar(*i).var());
         if (pval != Minisat::l_Undef)
-          assumps.push(model.primeLit(i->lit(pval == Minisat::l_False)));
+          pinputs.push_back(model.primeLit(i->lit(pval == Minisat::l_False)));
       }
-      int sz = assumps.size();
-      // extract and assert latches
+      if (!succ)
+        for (LitVec::const_iterator i = pinputs.begin(); i != pinputs.end(); 
+             ++i)
+          state(st).badInputs.push_back(model.unprimeLit(*i));
+      // extract latches
       LitVec latches;
       for (VarVec::const_iterator i = model.beginLatches(); 
            i != model.endLatches(); ++i) {
         Minisat::lbool val = fr.consecution->modelValue(i->var());
-        if (val != Minisat::l_Undef) {
-          Minisat::Lit la = i->lit(val == Minisat::l_False);
-          latches.push_back(la);
-          assumps.push(la);
-        }
+        if (val != Minisat::l_Undef)
+          latches.push_back(i->lit(val == Minisat::l_False));
       }
+      if (!ternary || !ternaryLift(st, pinputs, latches))
+        satLift(st, pinputs, latches);
+      return st;
+    }
+
+    // State s, inputs i, transition relation T, successor t:
+    //   s & i & T & ~t' is unsat
+    // Core assumptions reveal a lifting of s.
+    void satLift(size_t st, const LitVec & pinputs, const LitVec & latches) {
+      uint64_t start = time();  // stats
+      QueryScope qs(*this, QLift);
+      size_t succ = state(st).successor;
+      MSLitVec assumps;
+      assumps.capacity(1 + state(st).inputs.size() + pinputs.size() 
+                       + latches.size());
+      Minisat::Lit act = Minisat::mkLit(lifts->newVar());  // activation literal
+      Minisat::vec<Minisat::Lit> cls;
+      cls.push(~act);
+      cls.push(notInvConstraints);  // successor must satisfy inv. constraint
+      if (succ == 0)
+        cls.push(~model.primedError());
+      else
+        for (LitVec::const_iterator i = state(succ).latches.begin(); 
+             i != state(succ).latches.end(); ++i)
+          cls.push(model.primeLit(~*i));
+      lifts->addClause(cls);
+      // assert primary inputs, then primed inputs, since some
+      // properties include inputs
+      for (LitVec::const_iterator i = state(st).inputs.begin(); 
+           i != state(st).inputs.end(); ++i)
+        assumps.push(*i);
+      for (LitVec::const_iterator i = pinputs.begin(); i != pinputs.end(); ++i)
+        assumps.push(*i);
+      int sz = assumps.size();
+      // assert latches
+      for (LitVec::const_iterator i = latches.begin(); i != latches.end(); ++i)
+        assumps.push(*i);
       orderAssumps(assumps, false, sz);  // empirically found to be best choice
-      // State s, inputs i, transition relation T, successor t:
-      //   s & i & T & ~t' is unsat
-      // Core assumptions reveal a lifting of s.
-      ++nQuery; startTimer();  // stats
-      bool rv = lifts->solve(assumps);
-      endTimer(satTime);
+      // the activation literal goes last, as in checkConsecution(), so
+      // that lifts of similar states share a prefix of assumptions
+      assumps.push(act);
+      bool rv = solve(*lifts, assumps);
       assert (!rv);
       // obtain lifted latch set from unsat core
       for (LitVec::const_iterator i = latches.begin(); i != latches.end(); ++i)
-        if (lifts->conflict.has(~*i))
+        if (lifts->failed(*i))
           state(st).latches.push_back(*i);  // record lifted latches
       // deactivate negation of successor
       lifts->releaseVar(~act);
-      return st;
+      ++nSatLift; satLiftLits += state(st).latches.size();  // stats
+      satLiftTime += time() - start;
+    }
+
+    // Lifts by ternary simulation instead: s & i is still a
+    // predecessor of t if simulating it with some latches set to X
+    // yields t' (and the primed invariant constraints) nonetheless.
+    // Cheaper than satLift() but weaker, so it gives up if too few
+    // latches are dropped.
+    bool ternaryLift(size_t st, const LitVec & pinputs, const LitVec & latches) {
+      uint64_t start = time();  // stats
+      size_t succ = state(st).successor;
+      LitVec assignment(state(st).inputs);
+      assignment.insert(assignment.end(), pinputs.begin(), pinputs.end());
+      assignment.insert(assignment.end(), latches.begin(), latches.end());
+      LitVec targets;
+      if (succ == 0)
+        targets.push_back(model.primedError());
+      else
+        for (LitVec::const_iterator i = state(succ).latches.begin(); 
+             i != state(succ).latches.end(); ++i)
+          targets.push_back(model.primeLit(*i));
+      for (LitVec::const_iterator i = model.invariantConstraints().begin();
+           i != model.invariantConstraints().end(); ++i)
+        targets.push_back(model.primeLit(*i));
+      // try to drop infrequent literals first
+      LitVec order(latches), lifted;
+      orderCube(order);
+      bool rv = model.ternaryLift(assignment, targets, order, lifted)
+        && lifted.size() <= liftRatio * latches.size();
+      ternaryTime += time() - start;  // stats
+      if (!rv) {
+        ++nTernaryFallback;  // stats
+        return false;
+      }
+      sort(lifted.begin(), lifted.end());
+      state(st).latches.swap(lifted);  // record lifted latches
+      ++nTernaryLift; ternaryLits += state(st).latches.size();  // stats
+      return true;
     }
 
     // Checks if cube contains any initial states.
@@ -450,20 +836,132 @@ namespace IC3 {
       return !model.isInitial(latches);
     }
 
+    // Generalization query cache.  mic() and ctgDown() repeat
+    // consecution checks, across obligations and after CTG lemmas are
+    // added, that earlier answers settle:
+    //
+    //  o Proven cubes: if ~c is inductive relative to F_i, it stays so
+    //    as F_i gains lemmas, and it is inductive relative to F_j,
+    //    j < i, whose solver holds a superset of F_i's clauses.
+    //
+    //  o Subsumption by lemmas: if a lemma d of frame j > i is a
+    //    subset of c, then F_i & T => ~d' => ~c', so ~c is inductive
+    //    relative to F_i with core d.  (A subset of c merely proven
+    //    inductive does not suffice, since ~c does not imply ~d.)
+    //
+    //  o Failing cubes: the witness of a failed check relative to F_i
+    //    is also one relative to F_j, j >= i, until F_i gains a lemma
+    //    (see Frame::epoch).  This answers only checks that do not ask
+    //    for a predecessor.
+    struct Proven {
+      size_t level;  // greatest level proven at
+      LitVec core;
+    };
+    typedef map<LitVec, Proven, LitVecComp> ProvenMap;
+    typedef map<LitVec, pair<size_t, uint64_t>, LitVecComp> FailedMap;
+    // Lemmas in lexicographic order, so that those that start with
+    // a given literal are adjacent, with their frames.
+    struct LexComp {
+      bool operator()(const LitVec & v1, const LitVec & v2) const {
+        return lexicographical_compare(v1.begin(), v1.end(), 
+                                       v2.begin(), v2.end());
+      }
+    };
+    typedef map<LitVec, size_t, LexComp> LemmaIndex;
+    ProvenMap proven;
+    FailedMap failing;   // cube -> (level, epoch of that frame)
+    LemmaIndex lemmaLevels;
+    static const size_t genCacheMax = 1 << 16;  // entries, per map
+    uint64_t nGenLookups, nGenProven, nGenSubsumed, nGenFailing;  // stats
+
+    // Looks for a lemma at a level above fi that subsumes the sorted
+    // cube.
+    const LitVec * subsumingLemma(size_t fi, const LitVec & cube) {
+      if (lemmaLevels.empty()) return NULL;
+      bool dense = cube.size() >= denseMin;
+      if (dense) scratch.assign(cube);
+      const LitVec * rv = NULL;
+      for (size_t i = 0; i < cube.size() && !rv; ++i) {
+        // lemmas d with d[0] == cube[i]; the rest of d must be in
+        // cube[i+1..]
+        LitVec lo(1, cube[i]), hi(1, Minisat::toLit(toInt(cube[i]) + 1));
+        LemmaIndex::const_iterator end = lemmaLevels.lower_bound(hi);
+        for (LemmaIndex::const_iterator j = lemmaLevels.lower_bound(lo); 
+             j != end; ++j) {
+          const LitVec & d = j->first;
+          if (j->second <= fi || d.size() > cube.size() - i) continue;
+          bool sub = true;
+          for (size_t l = 1; l < d.size() && sub; ++l)
+            sub = dense ? scratch.has(d[l]) 
+                        : binary_search(cube.begin() + i + 1, cube.end(), 
+                                        d[l]);
+          if (sub) {
+            rv = &d;
+            break;
+          }
+        }
+      }
+      if (dense) scratch.reset(cube);
+      return rv;
+    }
+
     // Check if ~latches is inductive relative to frame fi.  If it's
     // inductive and core is provided, extracts the unsat core.  If
     // it's not inductive and pred is provided, extracts
-    // predecessor(s).
+    // predecessor(s).  Consults the generalization query cache first.
     bool consecution(size_t fi, const LitVec & latches, size_t succ = 0,
                      LitVec * core = NULL, size_t * pred = NULL, 
                      bool orderedCore = false)
+    {
+      PhaseTimer pt(*this, PConsecution);  // stats
+      ++nGenLookups;  // stats
+      LitVec key(latches);
+      sort(key.begin(), key.end());
+      if (!pred) {
+        FailedMap::const_iterator f = failing.find(key);
+        if (f != failing.end() && f->second.first <= fi 
+            && frames[f->second.first].epoch == f->second.second) {
+          ++nGenFailing;  // stats
+          return false;
+        }
+      }
+      ProvenMap::const_iterator p = proven.find(key);
+      if (p != proven.end() && p->second.level >= fi) {
+        ++nGenProven;  // stats
+        if (core) *core = p->second.core;
+        return true;
+      }
+      if (const LitVec * d = subsumingLemma(fi, key)) {
+        ++nGenSubsumed;  // stats
+        if (core) *core = *d;
+        return true;
+      }
+      LitVec tmp;
+      if (!core) core = &tmp;
+      if (!checkConsecution(fi, latches, succ, core, pred, orderedCore)) {
+        if (failing.size() >= genCacheMax) failing.clear();
+        failing[key] = make_pair(fi, frames[fi].epoch);
+        return false;
+      }
+      if (proven.size() >= genCacheMax) proven.clear();
+      pair<ProvenMap::iterator, bool> ins = 
+        proven.insert(make_pair(key, Proven()));
+      if (ins.second || ins.first->second.level < fi) {
+        ins.first->second.level = fi;
+        ins.first->second.core = *core;
+      }
+      return true;
+    }
+
+    // consecution() without the cache.
+    bool checkConsecution(size_t fi, const LitVec & latches, size_t succ,
+                          LitVec * core, size_t * pred, bool orderedCore)
     {
       Frame & fr = frames[fi];
       MSLitVec assumps, cls;
       assumps.capacity(1 + latches.size());
       cls.capacity(1 + latches.size());
       Minisat::Lit act = Minisat::mkLit(fr.consecution->newVar());
-      assumps.push(act);
       cls.push(~act);
       for (LitVec::const_iterator i = latches.begin(); 
            i != latches.end(); ++i) {
@@ -471,16 +969,18 @@ namespace IC3 {
         assumps.push(*i);  // push unprimed...
       }
       // ... order... (empirically found to best choice)
-      if (pred) orderAssumps(assumps, false, 1);
-      else orderAssumps(assumps, orderedCore, 1);
+      if (pred) orderAssumps(assumps, false);
+      else orderAssumps(assumps, orderedCore);
       // ... now prime
-      for (int i = 1; i < assumps.size(); ++i)
+      for (int i = 0; i < assumps.size(); ++i)
         assumps[i] = model.primeLit(assumps[i]);
-      fr.consecution->addClause_(cls);
+      // The activation literal goes last so that consecutive queries
+      // on similar cubes share a prefix of assumptions (see
+      // ReuseMinisat in SatSolver.cpp).
+      assumps.push(act);
+      fr.consecution->addClause(cls);
       // F_fi & ~latches & T & latches'
-      ++nQuery; startTimer();  // stats
-      bool rv = fr.consecution->solve(assumps);
-      endTimer(satTime);
+      bool rv = solve(*fr.consecution, assumps);
       if (rv) {
         // fails: extract predecessor(s)
         if (pred) *pred = stateOf(fr, succ);
@@ -491,15 +991,13 @@ namespace IC3 {
       if (core) {
         if (pred && orderedCore) {
           // redo with correctly ordered assumps
-          reverse(assumps+1, assumps+assumps.size());
-          ++nQuery; startTimer();  // stats
-          rv = fr.consecution->solve(assumps);
+          reverse(assumps+0, assumps+assumps.size()-1);
+          rv = solve(*fr.consecution, assumps);
           assert (!rv);
-          endTimer(satTime);
         }
         for (LitVec::const_iterator i = latches.begin(); 
              i != latches.end(); ++i)
-          if (fr.consecution->conflict.has(~model.primeLit(*i)))
+          if (fr.consecution->failed(model.primeLit(*i)))
             core->push_back(*i);
         if (!initiation(*core))
           *core = latches;
@@ -509,6 +1007,9 @@ namespace IC3 {
     }
 
     size_t maxDepth, maxCTGs, maxJoins, micAttempts;
+    bool basic;        // no CTGs or joins: their knobs stay at 0
+    bool ternary;      // lift by ternary simulation, falling back to SAT
+    float liftRatio;   // ... if more than this fraction of latches remain
 
     // Based on
     //
@@ -550,15 +1051,24 @@ namespace IC3 {
         }
         // not inductive, address interfering CTG
         LitVec ctgCore;
-        bool ret = false;
-        if (ctgs < maxCTGs && level > 1 && initiation(state(ctg).latches)
-            && consecution(level-1, state(ctg).latches, cubeState, &ctgCore)) {
+        bool ret = false, ctgInductive = false;
+        if (ctgs < maxCTGs && level > 1 && initiation(state(ctg).latches)) {
+          ++nCTGTry;  // stats
+          QueryScope qs(*this, QCtg);
+          ctgInductive = 
+            consecution(level-1, state(ctg).latches, cubeState, &ctgCore);
+          event(Trace::CTG, level, state(ctg).latches.size(), ctgInductive);
+        }
+        if (ctgInductive) {
           // CTG is inductive relative to level-1; push forward and generalize
           ++nCTG;  // stats
           ++ctgs;
           size_t j = level;
           // QUERY: generalize then push or vice versa?
-          while (j <= k && consecution(j, ctgCore)) ++j;
+          {
+            QueryScope qs(*this, QCtg);
+            while (j <= k && consecution(j, ctgCore)) ++j;
+          }
           mic(j-1, ctgCore, recDepth+1);
           addCube(j, ctgCore);
         }
@@ -566,10 +1076,15 @@ namespace IC3 {
           // ran out of CTG attempts, so join instead
           ctgs = 0;
           ++joins;
+          ++nJoin;  // stats
+          const LitVec & ctgLatches = state(ctg).latches;
+          bool dense = ctgLatches.size() >= denseMin;
+          if (dense) scratch.assign(ctgLatches);
           LitVec tmp;
           for (size_t i = 0; i < cube.size(); ++i)
-            if (binary_search(state(ctg).latches.begin(), 
-                              state(ctg).latches.end(), cube[i]))
+            if (dense ? scratch.has(cube[i]) 
+                      : binary_search(ctgLatches.begin(), ctgLatches.end(), 
+                                      cube[i]))
               tmp.push_back(cube[i]);
             else if (i < keepTo) {
               // previously failed when this literal was dropped
@@ -577,6 +1092,7 @@ namespace IC3 {
               ret = true;
               break;
             }
+          if (dense) scratch.reset(ctgLatches);
           cube = tmp;  // enlarged cube
         }
         else
@@ -594,6 +1110,8 @@ namespace IC3 {
     // inductive relative to the possibly modifed level.
     void mic(size_t level, LitVec & cube, size_t recDepth) {
       ++nmic;  // stats
+      PhaseTimer pt(*this, PMic);
+      QueryScope qs(*this, QGeneralize);
       // try dropping each literal in turn
       size_t attempts = micAttempts;
       orderCube(cube);
@@ -602,12 +1120,17 @@ namespace IC3 {
         cp.insert(cp.end(), cube.begin() + i+1, cube.end());
         if (ctgDown(level, cp, i, recDepth)) {
           // maintain original order
-          LitSet lits(cp.begin(), cp.end());
+          bool dense = cp.size() >= denseMin;
+          if (dense) scratch.assign(cp);
+          else sort(cp.begin(), cp.end());
           LitVec tmp;
           for (LitVec::const_iterator j = cube.begin(); j != cube.end(); ++j)
-            if (lits.find(*j) != lits.end())
+            if (dense ? scratch.has(*j) 
+                      : binary_search(cp.begin(), cp.end(), *j))
               tmp.push_back(*j);
+          if (dense) scratch.reset(cp);
           cube.swap(tmp);
+          event(Trace::MicDrop, level, i, cube.size());
           // reset attempts
           attempts = micAttempts;
         }
@@ -631,26 +1154,49 @@ namespace IC3 {
       mic(level, cube, 1);
     }
 
-    size_t earliest;  // track earliest modified level in a major iteration
+    // Membership tests against cubes of at least denseMin literals go
+    // through a latch-indexed bitset rather than binary search.
+    static const size_t denseMin = 32;
+    DenseCube scratch;
 
     // Adds cube to frames at and below level, unless !toAll, in which
-    // case only to level.
+    // case only to level.  A cube lives in at most one frame's
+    // borderCubes: copies in lower frames are removed here, and a
+    // cube already in a higher frame is not added again.
     void addCube(size_t level, LitVec & cube, bool toAll = true, 
                  bool silent = false)
     {
+      PhaseTimer pt(*this, PAddCube);  // stats
       sort(cube.begin(), cube.end());
+      for (size_t i = level+1; i < frames.size(); ++i)
+        if (frames[i].borderCubes.find(cube) != frames[i].borderCubes.end())
+          return;
       pair<CubeSet::iterator, bool> rv = frames[level].borderCubes.insert(cube);
       if (!rv.second) return;
+      for (size_t i = 1; i < level; ++i)
+        if (frames[i].borderCubes.erase(cube))
+          frames[i].pushFailed.erase(cube);
+      lemmaLevels[cube] = level;
+      ++levelStat(level).lemmas;  // stats
+      event(Trace::Lemma, level, cube.size(), toAll);
       if (!silent && verbose > 1) 
         cout << level << ": " << stringOfLitVec(cube) << endl;
-      earliest = min(earliest, level);
       MSLitVec cls;
       cls.capacity(cube.size());
       for (LitVec::const_iterator i = cube.begin(); i != cube.end(); ++i)
         cls.push(~*i);
-      for (size_t i = toAll ? 1 : level; i <= level; ++i)
+      for (size_t i = toAll ? 1 : level; i <= level; ++i) {
         frames[i].consecution->addClause(cls);
+        ++frames[i].epoch;
+      }
       if (toAll && !silent) updateLitOrder(cube, level);
+      if (port && !importing) {
+        Lemma lemma;
+        lemma.level = level;
+        lemma.cube = cube;
+        port->publish(lemma);
+        ++nLemmasSent;
+      }
     }
 
     // ~cube was found to be inductive relative to level; now see if
@@ -659,6 +1205,7 @@ namespace IC3 {
       // generalize
       mic(level, cube);
       // push
+      QueryScope qs(*this, QPush);
       do { ++level; } while (level <= k && consecution(level, cube));
       addCube(level, cube);
       return level;
@@ -668,11 +1215,14 @@ namespace IC3 {
 
     // Process obligations according to priority.
     bool handleObligations(PriorityQueue obls) {
+      QueryScope qs(*this, QObligation);
       while (!obls.empty()) {
         PriorityQueue::iterator obli = obls.begin();
         Obligation obl = *obli;
         LitVec core;
         size_t predi;
+        ++levelStat(obl.level).obligations;  // stats
+        event(Trace::Obligation, obl.level, obl.state, obl.depth);
         // Is the obligation fulfilled?
         if (consecution(obl.level, state(obl.state).latches, obl.state, 
                         &core, &predi)) {
@@ -689,8 +1239,10 @@ namespace IC3 {
           return false;
         }
         else {
-          ++nCTI;  // stats
+          ++nCTI; ++levelStat(k).ctis;  // stats
           // No, so focus on predecessor.
+          event(Trace::CTI, obl.level-1, predi, obl.depth+1);
+          if (obligationPort) reportObligation(predi);
           obls.insert(Obligation(predi, obl.level-1, obl.depth+1));
         }
       }
@@ -704,23 +1256,70 @@ namespace IC3 {
     bool strengthen() {
       Frame & frontier = frames[k];
       trivial = true;  // whether any cubes are generated
-      earliest = k+1;  // earliest frame with enlarged borderCubes
+      MSLitVec assumps;
+      assumps.push(model.primedError());
       while (true) {
-        ++nQuery; startTimer();  // stats
-        bool rv = frontier.consecution->solve(model.primedError());
-        endTimer(satTime);
+        bool rv = solve(*frontier.consecution, assumps);
         if (!rv) return true;
         // handle CTI with error successor
-        ++nCTI;  // stats
+        ++nCTI; ++levelStat(k).ctis;  // stats
         trivial = false;
         PriorityQueue pq;
         // enqueue main obligation and handle
-        pq.insert(Obligation(stateOf(frontier), k-1, 1));
+        size_t cti = stateOf(frontier);
+        event(Trace::CTI, k-1, cti, 1);
+        if (obligationPort) reportObligation(cti);
+        pq.insert(Obligation(cti, k-1, 1));
         if (!handleObligations(pq))
           return false;
         // finished with States for this iteration, so clean up
         resetStates();
+        if (port) importLemmas();
+      }
+    }
+
+    // Each state of an obligation reaches the error, so a check in
+    // the other direction that reaches it has a counterexample (see
+    // Reverse.h).  States are reported when found, not again when
+    // their obligations move up a level.
+    ObligationPort * obligationPort;
+
+    void reportObligation(size_t st) {
+      vector<Step> steps;
+      chain(st, steps);
+      obligationPort->obligation(steps);
+    }
+
+    // Lemmas exchanged with other checks through a LemmaPort.  Another
+    // check's lemma at level L holds in all states reachable within L
+    // steps, but it is added here only to a frame i <= L that it is
+    // inductive relative to: ~cube must hold initially, and F_{i-1} &
+    // ~cube & T must imply ~cube', so that the frames keep their
+    // invariants whatever the other check's frames are.  It is tried
+    // once, at the highest frame, which may be the one above the
+    // frontier.
+    LemmaPort * port;
+    bool importing;  // so that imported lemmas are not published back
+    uint64_t nLemmasSent, nLemmasReceived, nLemmasImported;  // stats
+
+    void importLemmas() {
+      vector<Lemma> lemmas;
+      port->receive(lemmas);
+      if (lemmas.empty()) return;
+      QueryScope qs(*this, QImport);
+      importing = true;
+      for (vector<Lemma>::iterator i = lemmas.begin(); i != lemmas.end(); 
+           ++i) {
+        ++nLemmasReceived;
+        size_t level = min(i->level, k+1);
+        sort(i->cube.begin(), i->cube.end());
+        if (level == 0 || i->cube.empty() || !initiation(i->cube)) continue;
+        LitVec core;
+        if (!consecution(level-1, i->cube, 0, &core)) continue;
+        addCube(level, core);
+        ++nLemmasImported;
       }
+      importing = false;
     }
 
     // Propagates clauses forward using induction.  If any frame has
@@ -729,133 +1328,735 @@ namespace IC3 {
     // strengthenings of the property.  See the four invariants of IC3
     // in the original paper.
     bool propagate() {
+      PhaseTimer pt(*this, PPropagate);  // stats
+      QueryScope qs(*this, QPropagate);
       if (verbose > 1) cout << "propagate" << endl;
-      // 1. clean up: remove c in frame i if c appears in frame j when i < j
-      CubeSet all;
-      for (size_t i = k+1; i >= earliest; --i) {
-        Frame & fr = frames[i];
-        CubeSet rem, nall;
-        set_difference(fr.borderCubes.begin(), fr.borderCubes.end(),
-                       all.begin(), all.end(),
-                       inserter(rem, rem.end()), LitVecComp());
-        if (verbose > 1)
-          cout << i << " " << fr.borderCubes.size() << " " << rem.size() << " ";
-        fr.borderCubes.swap(rem);
-        set_union(rem.begin(), rem.end(),
-                  all.begin(), all.end(), 
-                  inserter(nall, nall.end()), LitVecComp());
-        all.swap(nall);
-        for (CubeSet::const_iterator i = fr.borderCubes.begin(); 
-             i != fr.borderCubes.end(); ++i)
-          assert (all.find(*i) != all.end());
-        if (verbose > 1)
-          cout << all.size() << endl;
-      }
-      // 2. check if each c in frame i can be pushed to frame j
-      for (size_t i = trivial ? k : 1; i <= k; ++i) {
-        int ckeep = 0, cprop = 0, cdrop = 0;
+      // 1. check if each c in frame i can be pushed to frame i+1; a
+      //    cube that failed before is retried only if frame i has
+      //    gained lemmas since (addCube() keeps each cube in only one
+      //    frame, so there are no duplicates to clean up first)
+      for (size_t i = 1; i <= k; ++i) {
+        int ckeep = 0, cprop = 0, cskip = 0;
         Frame & fr = frames[i];
         for (CubeSet::iterator j = fr.borderCubes.begin(); 
              j != fr.borderCubes.end();) {
+          CubeEpochs::iterator failed = fr.pushFailed.find(*j);
+          if (failed != fr.pushFailed.end() && failed->second == fr.epoch) {
+            ++cskip;
+            ++j;
+            continue;
+          }
           LitVec core;
-          if (consecution(i, *j, 0, &core)) {
+          bool pushed = consecution(i, *j, 0, &core);
+          event(Trace::Push, i, j->size(), pushed);
+          if (pushed) {
             ++cprop;
+            if (failed != fr.pushFailed.end()) fr.pushFailed.erase(failed);
+            LitVec cube = *j;
+            fr.borderCubes.erase(j);
+            lemmaLevels.erase(cube);
             // only add to frame i+1 unless the core is reduced
-            addCube(i+1, core, core.size() < j->size(), true);
-            CubeSet::iterator tmp = j;
-            ++j;
-            fr.borderCubes.erase(tmp);
+            addCube(i+1, core, core.size() < cube.size(), true);
+            // addCube() may have removed other cubes from this frame
+            j = fr.borderCubes.upper_bound(cube);
           }
           else {
             ++ckeep;
+            fr.pushFailed[*j] = fr.epoch;
             ++j;
           }
         }
+        levelStat(i).pushed += cprop;  // stats
+        nPushSkipped += cskip;         // stats
         if (verbose > 1)
-          cout << i << " " << ckeep << " " << cprop << " " << cdrop << endl;
-        if (fr.borderCubes.empty())
+          cout << i << " " << ckeep << " " << cprop << " " << cskip << endl;
+        if (fr.borderCubes.empty()) {
+          proofLevel = i;
           return true;
+        }
       }
-      // 3. simplify frames
+      // 2. simplify frames
       for (size_t i = trivial ? k : 1; i <= k+1; ++i)
         frames[i].consecution->simplify();
       lifts->simplify();
       return false;
     }
 
-    int nQuery, nCTI, nCTG, nmic;
-    clock_t startTime, satTime;
-    int nCoreReduced, nAbortJoin, nAbortMic;
-    clock_t time() {
-      struct tms t;
-      times(&t);
-      return t.tms_utime;
+    // Adaptive generalization (-a).  After each level, adapt() scores
+    // the work since its last decision by lemma quality per SAT
+    // query --- lemmas learned, discounted by their average length,
+    // per query --- and hill-climbs over maxCTGs, maxDepth,
+    // micAttempts, and maxJoins, one step at a time.  A step that
+    // lowered the score is undone; otherwise, the window's statistics
+    // suggest the next step:
+    //
+    //  o CTGs that are rarely inductive waste queries, so fewer are
+    //    tried; CTGs that usually are pay off, so more are tried
+    //    (and, at the maximum, more deeply).
+    //
+    //  o mic() giving up often (nAbortMic) means that micAttempts
+    //    cuts it off while literals can still be dropped.
+    //
+    //  o Joins that are mostly abandoned (nAbortJoin) are wasted.
+    //
+    //  o Frequent core reductions are cheap generalization, so deeper
+    //    recursion is affordable.
+    //
+    // Otherwise, the knobs are tried in turn.
+    bool adaptive;
+    enum Knob { KCTGs, KDepth, KMic, KJoins, NKnobs };
+    // statistics at the start of the current window
+    struct Window {
+      int queries, ctgTries, ctgs, joins, abortJoins, mics, abortMics, 
+        coreReduced;
+      float lemmas, lits;
+    };
+    Window window;
+    size_t adaptMoves, adaptUndos;  // stats
+    int lastKnob, lastDir;  // the last step, if it is still on trial
+    int tabuKnob, tabuDir;  // the last step undone
+    int nextKnob;           // round robin
+    double lastScore;
+
+    static const char * knobName(int kn) {
+      static const char * names[] = 
+        { "maxCTGs", "maxDepth", "micAttempts", "maxJoins" };
+      return names[kn];
+    }
+    size_t & knob(int kn) {
+      switch (kn) {
+      case KCTGs: return maxCTGs;
+      case KDepth: return maxDepth;
+      case KMic: return micAttempts;
+      default: return maxJoins;
+      }
     }
-    clock_t timer;
+    // Under basic generalization, only micAttempts is tuned.
+    bool tunable(int kn) const { return !basic || kn == KMic; }
+    // Moves knob kn one step in direction dir; returns false if it is
+    // already at its bound.
+    bool step(int kn, int dir) {
+      static const size_t lo[] = { 0, 0, 1, 0 };
+      static const size_t hi[] = { 8, 4, 16, 1<<20 };
+      size_t & v = knob(kn), old = v;
+      if (kn == KJoins)
+        // 0, 1, 4, 16, ..., then unlimited
+        v = dir > 0 ? (v == 0 ? 1 : (v >= (1<<10) ? hi[kn] : v * 4)) 
+                    : (v > (1<<10) ? (1<<10) : v / 4);
+      else if (dir > 0 ? v < hi[kn] : v > lo[kn])
+        v += dir;
+      v = min(max(v, lo[kn]), hi[kn]);
+      return v != old;
+    }
+    void logAdapt(const char * what, int kn, size_t old, const string & why) {
+      if (!verbose) return;
+      cout << ". Adapt level " << k << ": " << what << " " << knobName(kn) 
+           << " " << old << " -> " << knob(kn) << " (" << why << ")" << endl;
+    }
+    void startWindow() {
+      window.queries = nQuery; window.ctgTries = nCTGTry; window.ctgs = nCTG;
+      window.joins = nJoin; window.abortJoins = nAbortJoin; 
+      window.mics = nmic; window.abortMics = nAbortMic;
+      window.coreReduced = nCoreReduced;
+      window.lemmas = numUpdates; window.lits = numLits;
+    }
+
+    void adapt() {
+      float lemmas = numUpdates - window.lemmas;
+      int queries = nQuery - window.queries;
+      // too little evidence; keep accumulating
+      if (lemmas < 8 || queries == 0) return;
+      double avgLen = (numLits - window.lits) / lemmas;
+      double score = lemmas / queries / max(avgLen, 1.0);
+      ostringstream why;
+      why.precision(3);
+      if (lastKnob != NKnobs) {
+        if (score < lastScore) {
+          size_t old = knob(lastKnob);
+          step(lastKnob, -lastDir);
+          ++adaptUndos;  // stats
+          why << "score " << score << " < " << lastScore;
+          logAdapt("undo", lastKnob, old, why.str());
+          tabuKnob = lastKnob; tabuDir = lastDir;
+          lastKnob = NKnobs;
+          // keep lastScore as the score to beat
+          startWindow();
+          return;
+        }
+        tabuKnob = NKnobs;
+      }
+      lastScore = score;
+      // choose the next step
+      int ctgTries = nCTGTry - window.ctgTries, ctgs = nCTG - window.ctgs;
+      int joins = nJoin - window.joins, 
+        abortJoins = nAbortJoin - window.abortJoins;
+      int mics = nmic - window.mics, abortMics = nAbortMic - window.abortMics;
+      int reduced = nCoreReduced - window.coreReduced;
+      double ctgRate = ctgTries ? (double) ctgs / ctgTries : 0;
+      int kn = NKnobs, dir = 0;
+      if (ctgTries >= 8 && ctgRate < 0.2) {
+        kn = KCTGs; dir = -1;
+        why << "CTGs inductive " << (int) (100 * ctgRate) << "%";
+      }
+      else if (ctgTries >= 8 && ctgRate > 0.6) {
+        kn = knob(KCTGs) < 8 ? KCTGs : KDepth; dir = 1;
+        why << "CTGs inductive " << (int) (100 * ctgRate) << "%";
+      }
+      else if (mics >= 8 && abortMics > mics / 2) {
+        kn = KMic; dir = 1;
+        why << abortMics << " of " << mics << " mics cut off";
+      }
+      else if (mics >= 8 && abortMics < mics / 10) {
+        kn = KMic; dir = -1;
+        why << abortMics << " of " << mics << " mics cut off";
+      }
+      else if (joins >= 8 && abortJoins > joins / 2) {
+        kn = KJoins; dir = -1;
+        why << abortJoins << " of " << joins << " joins abandoned";
+      }
+      else if (reduced > queries / 4) {
+        kn = KDepth; dir = 1;
+        why << reduced << " core reductions in " << queries << " queries";
+      }
+      if (kn != NKnobs 
+          && (!tunable(kn) || (kn == tabuKnob && dir == tabuDir)))
+        kn = NKnobs;
+      for (int i = 0; kn == NKnobs && i < 2 * NKnobs; ++i) {
+        // round robin, trying up before down
+        int c = nextKnob / 2, d = nextKnob % 2 ? -1 : 1;
+        nextKnob = (nextKnob + 1) % (2 * NKnobs);
+        if (!tunable(c) || (c == tabuKnob && d == tabuDir)) continue;
+        size_t v = knob(c);
+        if (step(c, d)) {
+          knob(c) = v;
+          kn = c; dir = d;
+          why.str("");
+          why << "exploring";
+        }
+      }
+      size_t old = kn != NKnobs ? knob(kn) : 0;
+      if (kn != NKnobs && step(kn, dir)) {
+        ++adaptMoves;  // stats
+        why << ", score " << score;
+        logAdapt("try", kn, old, why.str());
+        lastKnob = kn; lastDir = dir;
+      }
+      else
+        lastKnob = NKnobs;
+      startWindow();
+    }
+
+    int nQuery, nCTI, nCTG, nCTGTry, nJoin, nmic;
+    uint64_t startTime, satTime;  // ns
+    int nCoreReduced, nAbortJoin, nAbortMic;
+    uint64_t nPushSkipped;
+    int nSatLift, nTernaryLift, nTernaryFallback;
+    float satLiftLits, ternaryLits;
+    uint64_t satLiftTime, ternaryTime;
+    uint64_t time() { return nanotime(); }
+    uint64_t timer;
     void startTimer() { timer = time(); }
-    void endTimer(clock_t & t) { t += (time() - timer); }
+    void endTimer(uint64_t & t) { t += (time() - timer); }
+
+    // Profiling: inclusive time per phase of the engine, SAT latency
+    // histograms per query type (see QueryScope), and per-level counts.
+    enum Phase { PLift, PConsecution, PMic, PAddCube, PPropagate, NPhases };
+    static const char * phaseName(int p) {
+      static const char * names[] = 
+        { "stateOf", "consecution", "mic", "addCube", "propagate" };
+      return names[p];
+    }
+    uint64_t phaseTime[NPhases], phaseCalls[NPhases];
+    int phaseDepth[NPhases];
+#ifdef IC3_PERF
+    PerfCounters perf;
+    uint64_t phasePerf[NPhases][PerfCounters::NCounters];
+#endif
+    // Times a phase; recursive entries (e.g., mic within ctgDown
+    // within mic) are counted once.  With IC3_PERF, also counts
+    // hardware events.
+    struct PhaseTimer {
+      PhaseTimer(IC3 & _ic3, Phase _p) : ic3(_ic3), p(_p) {
+        ++ic3.phaseCalls[p];
+        if (ic3.phaseDepth[p]++ == 0) {
+          start = nanotime();
+#ifdef IC3_PERF
+          ic3.perf.read(events);
+#endif
+        }
+      }
+      ~PhaseTimer() {
+        if (--ic3.phaseDepth[p] == 0) {
+          ic3.phaseTime[p] += nanotime() - start;
+#ifdef IC3_PERF
+          uint64_t now[PerfCounters::NCounters];
+          ic3.perf.read(now);
+          for (int c = 0; c < PerfCounters::NCounters; ++c)
+            ic3.phasePerf[p][c] += now[c] - events[c];
+#endif
+        }
+      }
+      IC3 & ic3;
+      Phase p;
+      uint64_t start;
+#ifdef IC3_PERF
+      uint64_t events[PerfCounters::NCounters];
+#endif
+    };
+
+    enum QueryType { QFrontier, QObligation, QLift, QGeneralize, QCtg, 
+                     QPush, QPropagate, QImport, QBase, NQueryTypes };
+    static const char * queryName(int q) {
+      static const char * names[] = { "frontier", "obligation", "lift", 
+                                      "generalize", "ctg", "push", 
+                                      "propagate", "import", "base" };
+      return names[q];
+    }
+    QueryType qtype;  // type of the queries issued in the current scope
+    Histogram queryLatency[NQueryTypes];
+    // propagations, and assignments kept rather than propagated again
+    uint64_t queryProps[NQueryTypes], queryReused[NQueryTypes];
+    struct QueryScope {
+      QueryScope(IC3 & _ic3, QueryType q) : ic3(_ic3), saved(_ic3.qtype) {
+        ic3.qtype = q;
+      }
+      ~QueryScope() { ic3.qtype = saved; }
+      IC3 & ic3;
+      QueryType saved;
+    };
+
+    struct LevelStats {
+      LevelStats() : queries(0), obligations(0), ctis(0), lemmas(0), 
+                     pushed(0) {}
+      uint64_t queries, obligations, ctis, lemmas, pushed;
+    };
+    vector<LevelStats> levelStats;
+    LevelStats & levelStat(size_t level) {
+      if (level >= levelStats.size()) levelStats.resize(level+1);
+      return levelStats[level];
+    }
+
+    ostream * json;     // JSON statistics, if requested
+    bool jsonPerLevel;  // ... also after every level (JSON Lines)
+    Trace::Writer * trace;  // binary event trace, if requested
+
+    void event(Trace::Event e, size_t level, uint32_t a = 0, uint32_t b = 0) {
+      if (trace) trace->record(e, (uint32_t) level, time() - startTime, a, b);
+    }
+
     void printStats() {
       if (!verbose) return;
-      clock_t etime = time();
-      cout << ". Elapsed time: " << ((double) etime / sysconf(_SC_CLK_TCK)) << endl;
-      etime -= startTime;
+      uint64_t etime = time() - startTime;
+      cout << ". Elapsed time: " << etime / 1e9 << endl;
       if (!etime) etime = 1;
       cout << ". % SAT:        " << (int) (100 * (((double) satTime) / ((double) etime))) << endl;
       cout << ". K:            " << k << endl;
       cout << ". # Queries:    " << nQuery << endl;
+      cout << ". # Conflicts:  " << nConflicts << endl;
       cout << ". # CTIs:       " << nCTI << endl;
       cout << ". # CTGs:       " << nCTG << endl;
       cout << ". # mic calls:  " << nmic << endl;
-      cout << ". Queries/sec:  " << (int) (((double) nQuery) / ((double) etime) * sysconf(_SC_CLK_TCK)) << endl;
-      cout << ". Mics/sec:     " << (int) (((double) nmic) / ((double) etime) * sysconf(_SC_CLK_TCK)) << endl;
+      cout << ". Queries/sec:  " << (int) (((double) nQuery) / ((double) etime) * 1e9) << endl;
+      cout << ". Mics/sec:     " << (int) (((double) nmic) / ((double) etime) * 1e9) << endl;
       cout << ". # Red. cores: " << nCoreReduced << endl;
       cout << ". # Int. joins: " << nAbortJoin << endl;
       cout << ". # Int. mics:  " << nAbortMic << endl;
+      cout << ". # Push skips: " << nPushSkipped << endl;
+      if (port)
+        cout << ". Lemmas:       " << nLemmasSent << " sent, " 
+             << nLemmasImported << " of " << nLemmasReceived 
+             << " received imported" << endl;
+      if (share)
+        cout << ". Shared:       " << nShareOffered - nShareRejected 
+             << " of " << nShareOffered << " offered, " << nShareImports 
+             << " imports, " << nShareUsed << " used in conflicts" << endl;
+      const Model::InitStats & is = model.initStats();
+      cout << ". Init checks:  " << is.calls << ", " 
+           << (int) (100.0 * (is.calls - is.sat) / max(is.calls, 
+                                                       (uint64_t) 1))
+           << "% fast: " << is.syntactic << " syntactic, " << is.ternary 
+           << " ternary, " << is.memo << " memoized, " << is.sat << " SAT" 
+           << endl;
+      const Model::CNFStats & cs = model.cnfStats();
+      cout << ". CNF (TR):     " << model.encoding() << ", " << cs.vars 
+           << " vars, " << cs.clauses << " clauses; " << cs.simpVars 
+           << " vars, " << cs.simpClauses << " clauses after " 
+           << cs.elimNs / 1000000.0 << " ms of elimination" << endl;
+      if (model.encoding() == "compact")
+        cout << ". CNF gates:    " << cs.ands << " ANDs (" << cs.collapsed 
+             << " collapsed), " << cs.muxes << " MUXes, " << cs.xors 
+             << " XORs" << endl;
+      uint64_t genHits = nGenProven + nGenSubsumed + nGenFailing;
+      cout << ". Gen. cache:   " << genHits << " of " << nGenLookups 
+           << " checks (" << (int) (100.0 * genHits / max(nGenLookups, 
+                                                          (uint64_t) 1))
+           << "%): " << nGenProven << " proven, " << nGenSubsumed 
+           << " subsumed, " << nGenFailing << " failing" << endl;
+      if (trace)
+        cout << ". Trace events: " << trace->records() << ", " 
+             << trace->stalls() << " stalls" << endl;
+      if (adaptive) {
+        cout << ". Adapt steps:  " << adaptMoves << ", " << adaptUndos 
+             << " undone" << endl;
+        cout << ". Parameters:   maxCTGs " << maxCTGs << ", maxDepth " 
+             << maxDepth << ", micAttempts " << micAttempts << ", maxJoins " 
+             << maxJoins << endl;
+      }
       if (numUpdates) cout << ". Avg lits/cls: " << numLits / numUpdates << endl;
+      cout << ". # SAT lifts:  " << nSatLift << endl;
+      if (nSatLift) cout << ". Avg SAT lift: " << satLiftLits / nSatLift << endl;
+      cout << ". SAT lift sec: " << satLiftTime / 1e9 << endl;
+      if (ternary) {
+        cout << ". # Tern lifts: " << nTernaryLift << endl;
+        if (nTernaryLift) cout << ". Avg tern.:    " << ternaryLits / nTernaryLift << endl;
+        cout << ". # Tern fails: " << nTernaryFallback << endl;
+        cout << ". Tern sec:     " << ternaryTime / 1e9 << endl;
+      }
+      for (int p = 0; p < NPhases; ++p)
+        cout << ". Phase " << phaseName(p) << ": " << phaseCalls[p] 
+             << " calls, " << phaseTime[p] / 1e9 << " s" << endl;
+#ifdef IC3_PERF
+      if (!perf.ok())
+        cout << ". Perf counters unavailable: " << perf.why() << endl;
+      else
+        for (int p = 0; p < NPhases; ++p) {
+          const uint64_t * v = phasePerf[p];
+          double kinstr = max(v[PerfCounters::Instructions], (uint64_t) 1) 
+                          / 1e3;
+          cout << ". Perf " << phaseName(p) << ": " 
+               << v[PerfCounters::Cycles] << " cycles, IPC " 
+               << (double) v[PerfCounters::Instructions] 
+                  / max(v[PerfCounters::Cycles], (uint64_t) 1)
+               << ", LLC misses/kinstr " 
+               << v[PerfCounters::LLCMisses] / kinstr
+               << ", branch misses/kinstr " 
+               << v[PerfCounters::BranchMisses] / kinstr << endl;
+        }
+#endif
+      for (int q = 0; q < NQueryTypes; ++q) {
+        const Histogram & h = queryLatency[q];
+        if (!h.count()) continue;
+        cout << ". Query " << queryName(q) << ": " << h.count() 
+             << ", mean " << h.sum() / h.count() / 1e3 << " us, p50 < " 
+             << h.quantile(0.5) / 1e3 << " us, p99 < " 
+             << h.quantile(0.99) / 1e3 << " us, " << queryProps[q] 
+             << " props";
+        if (queryReused[q])
+          cout << ", " << queryReused[q] << " reused (" 
+               << (int) (100.0 * queryReused[q] 
+                         / (queryReused[q] + queryProps[q])) << "%)";
+        cout << endl;
+      }
     }
 
-    friend bool check(Model &, int, bool, bool);
+    // Writes all statistics as one line of JSON.
+    void writeJson(ostream & os, const char * result) {
+      uint64_t etime = time() - startTime;
+      struct rusage ru;
+      getrusage(RUSAGE_SELF, &ru);
+      os << "{\"result\":\"" << result << "\",\"k\":" << k
+         << ",\"elapsed_ns\":" << etime << ",\"sat_ns\":" << satTime
+         << ",\"max_rss_kb\":" << ru.ru_maxrss
+         << ",\"queries\":" << nQuery << ",\"conflicts\":" << nConflicts
+         << ",\"ctis\":" << nCTI << ",\"ctgs\":" << nCTG 
+         << ",\"mics\":" << nmic << ",\"core_reduced\":" << nCoreReduced
+         << ",\"aborted_joins\":" << nAbortJoin 
+         << ",\"aborted_mics\":" << nAbortMic
+         << ",\"push_skipped\":" << nPushSkipped
+         << ",\"init_checks\":{\"calls\":" << model.initStats().calls
+         << ",\"syntactic\":" << model.initStats().syntactic 
+         << ",\"ternary\":" << model.initStats().ternary
+         << ",\"memo\":" << model.initStats().memo 
+         << ",\"sat\":" << model.initStats().sat << "}"
+         << ",\"cnf\":{\"encoding\":\"" << model.encoding() << "\""
+         << ",\"vars\":" << model.cnfStats().vars 
+         << ",\"clauses\":" << model.cnfStats().clauses 
+         << ",\"simp_vars\":" << model.cnfStats().simpVars 
+         << ",\"simp_clauses\":" << model.cnfStats().simpClauses 
+         << ",\"elim_ns\":" << model.cnfStats().elimNs 
+         << ",\"ands\":" << model.cnfStats().ands 
+         << ",\"collapsed\":" << model.cnfStats().collapsed 
+         << ",\"muxes\":" << model.cnfStats().muxes 
+         << ",\"xors\":" << model.cnfStats().xors << "}"
+         << ",\"gen_cache\":{\"lookups\":" << nGenLookups 
+         << ",\"proven\":" << nGenProven << ",\"subsumed\":" << nGenSubsumed
+         << ",\"failing\":" << nGenFailing << "}"
+         << ",\"share\":{\"offered\":" << nShareOffered
+         << ",\"rejected\":" << nShareRejected 
+         << ",\"imports\":" << nShareImports 
+         << ",\"used\":" << nShareUsed << "}"
+         << ",\"exchange\":{\"sent\":" << nLemmasSent
+         << ",\"received\":" << nLemmasReceived 
+         << ",\"imported\":" << nLemmasImported << "}"
+         << ",\"params\":{\"max_ctgs\":" << maxCTGs 
+         << ",\"max_depth\":" << maxDepth 
+         << ",\"mic_attempts\":" << micAttempts 
+         << ",\"max_joins\":" << maxJoins
+         << ",\"adapt_steps\":" << adaptMoves 
+         << ",\"adapt_undos\":" << adaptUndos << "}"
+         << ",\"lemmas\":" << numUpdates 
+         << ",\"avg_lemma\":" << (numUpdates ? numLits / numUpdates : 0)
+         << ",\"lifts\":{\"sat\":" << nSatLift 
+         << ",\"sat_lits\":" << satLiftLits << ",\"sat_ns\":" << satLiftTime
+         << ",\"ternary\":" << nTernaryLift 
+         << ",\"ternary_lits\":" << ternaryLits
+         << ",\"ternary_fallbacks\":" << nTernaryFallback
+         << ",\"ternary_ns\":" << ternaryTime << "}";
+      os << ",\"phases\":{";
+      for (int p = 0; p < NPhases; ++p) {
+        os << (p ? "," : "") << "\"" << phaseName(p) << "\":{\"calls\":" 
+           << phaseCalls[p] << ",\"ns\":" << phaseTime[p];
+#ifdef IC3_PERF
+        if (perf.ok())
+          for (int c = 0; c < PerfCounters::NCounters; ++c)
+            os << ",\"" << PerfCounters::name(c) << "\":" << phasePerf[p][c];
+#endif
+        os << "}";
+      }
+      os << "},\"queries_by_type\":{";
+      for (int q = 0; q < NQueryTypes; ++q) {
+        os << (q ? "," : "") << "\"" << queryName(q) << "\":";
+        queryLatency[q].json(os);
+      }
+      os << "},\"propagations_by_type\":{";
+      for (int q = 0; q < NQueryTypes; ++q)
+        os << (q ? "," : "") << "\"" << queryName(q) << "\":{\"props\":" 
+           << queryProps[q] << ",\"reused\":" << queryReused[q] << "}";
+      os << "},\"levels\":[";
+      for (size_t i = 0; i < levelStats.size(); ++i) {
+        const LevelStats & ls = levelStats[i];
+        os << (i ? "," : "") << "{\"level\":" << i 
+           << ",\"queries\":" << ls.queries 
+           << ",\"obligations\":" << ls.obligations
+           << ",\"ctis\":" << ls.ctis << ",\"lemmas\":" << ls.lemmas
+           << ",\"pushed\":" << ls.pushed << "}";
+      }
+      os << "]}" << endl;
+    }
 
-  };
+    // A random cube over cubeSize distinct latches.
+    LitVec randomCube(size_t cubeSize) {
+      size_t nl = model.endLatches() - model.beginLatches();
+      LitVec cube;
+      set<size_t> used;
+      while (cube.size() < min(cubeSize, nl)) {
+        size_t i = nextRandom() % nl;
+        if (!used.insert(i).second) continue;
+        cube.push_back((model.beginLatches()+i)->lit(nextRandom() % 2));
+      }
+      sort(cube.begin(), cube.end());
+      return cube;
+    }
 
-  // IC3 does not check for 0-step and 1-step reachability, so do it
-  // separately.
-  bool baseCases(Model & model) {
-    Minisat::Solver * base0 = model.newSolver();
-    model.loadInitialCondition(*base0);
-    model.loadError(*base0);
-    bool rv = base0->solve(model.error());
-    delete base0;
-    if (rv) return false;
-
-    Minisat::Solver * base1 = model.newSolver();
-    model.loadInitialCondition(*base1);
-    model.loadTransitionRelation(*base1);
-    rv = base1->solve(model.primedError());
-    delete base1;
-    if (rv) return false;
+    void microbench(size_t reps, size_t cubeSize, vector<Timings> & timings) {
+      extend();
+      // consecution of random cubes relative to F_1
+      timings.push_back(Timings("consecution"));
+      for (size_t r = 0; r < reps; ++r) {
+        LitVec cube = randomCube(cubeSize), core;
+        uint64_t start = nanotime();
+        consecution(1, cube, 0, &core);
+        timings.back().ns.push_back(nanotime() - start);
+      }
+      // lifting of predecessors of random cubes; unreachable cubes
+      // are skipped
+      timings.push_back(Timings("stateOf"));
+      for (size_t r = 0; r < 100 * reps && timings.back().ns.size() < reps; 
+           ++r) {
+        size_t succ = newState();
+        state(succ).successor = 0;
+        state(succ).latches = randomCube(cubeSize);
+        MSLitVec assumps;
+        for (LitVec::const_iterator i = state(succ).latches.begin(); 
+             i != state(succ).latches.end(); ++i)
+          assumps.push(model.primeLit(*i));
+        if (solve(*frames[1].consecution, assumps)) {
+          uint64_t start = nanotime();
+          stateOf(frames[1], succ);
+          timings.back().ns.push_back(nanotime() - start);
+        }
+        resetStates();
+      }
+      // addCube of random cubes to F_1 (last, as it changes F_1)
+      timings.push_back(Timings("addCube"));
+      for (size_t r = 0; r < reps; ++r) {
+        LitVec cube = randomCube(cubeSize);
+        uint64_t start = nanotime();
+        addCube(1, cube, true, true);
+        timings.back().ns.push_back(nanotime() - start);
+      }
+    }
 
-    model.lockPrimes();
+    // The state, and if it has steps, its successor, of a satisfying
+    // assignment of a base case.
+    void baseWitness(SatSolver & slv, size_t steps, vector<Step> & witness) {
+      for (size_t t = 0; t < steps; ++t) {
+        witness.push_back(Step());
+        Step & st = witness.back();
+        for (VarVec::const_iterator i = model.beginInputs(); 
+             i != model.endLatches(); ++i) {
+          const Var & v = t ? model.primeVar(*i) : *i;
+          Minisat::lbool val = slv.modelValue(v.var());
+          if (val == Minisat::l_Undef) continue;
+          LitVec & lits = i < model.endInputs() ? st.inputs : st.latches;
+          lits.push_back(i->lit(val == Minisat::l_False));
+        }
+      }
+    }
+
+    // IC3 does not check for 0-step and 1-step reachability, so do it
+    // separately, through solve() so that the budgets and cancellation
+    // cover it.  Fills witness, if given, when one fails.
+    bool baseCases(vector<Step> * witness) {
+      QueryScope qs(*this, QBase);
+      for (size_t steps = 1; steps <= 2; ++steps) {
+        SatSolver * base = model.newSolver();
+        model.loadInitialCondition(*base);
+        if (steps == 1)
+          model.loadError(*base);
+        else
+          model.loadTransitionRelation(*base);
+        MSLitVec assumps;
+        assumps.push(steps == 1 ? model.error() : model.primedError());
+        bool rv;
+        try {
+          rv = solve(*base, assumps);
+        }
+        catch (const OutOfBudget &) {
+          delete base;
+          throw;
+        }
+        if (rv && witness) baseWitness(*base, steps, *witness);
+        delete base;
+        if (rv) return false;
+      }
+      model.lockPrimes();
+      return true;
+    }
 
+    friend Result check(Model &, const Options &, Outcome *);
+    friend void microbench(Model &, size_t, size_t, unsigned int, 
+                           vector<Timings> &);
+
+  };
+
+  void CancelToken::cancel() {
+    lock_guard<mutex> lock(mtx);
+    flag = true;
+    for (size_t i = 0; i < running.size(); ++i)
+      running[i]->interrupt();
+  }
+
+  // Checking the flag under the lock means that either cancel() sees
+  // the solver or the solver sees the flag.
+  bool CancelToken::attach(SatSolver * slv) {
+    lock_guard<mutex> lock(mtx);
+    if (flag) return false;
+    running.push_back(slv);
     return true;
   }
 
+  void CancelToken::detach(SatSolver * slv) {
+    lock_guard<mutex> lock(mtx);
+    running.erase(find(running.begin(), running.end(), slv));
+  }
+
   // External function to make the magic happen.
-  bool check(Model & model, int verbose, bool basic, bool random) {
-    if (!baseCases(model))
-      return false;
+  Result check(Model & model, const Options & options, Outcome * outcome) {
+    uint64_t start = nanotime();
+    if (outcome) *outcome = Outcome();
     IC3 ic3(model);
-    ic3.verbose = verbose;
-    if (basic) {
+    ic3.verbose = options.verbose;
+    ic3.maxDepth = options.maxDepth;
+    ic3.maxCTGs = options.maxCTGs;
+    ic3.maxJoins = options.maxJoins;
+    ic3.micAttempts = options.micAttempts;
+    if (options.basic) {
+      ic3.basic = true;
       ic3.maxDepth = 0;
       ic3.maxJoins = 0;
       ic3.maxCTGs = 0;
     }
-    if (random) ic3.random = true;
-    bool rv = ic3.check();
-    if (!rv && verbose > 1) ic3.printWitness();
-    if (verbose) ic3.printStats();
+    if (options.random) {
+      ic3.random = true;
+      ic3.seed = options.seed ? options.seed : (unsigned int) nanotime();
+      // so that an interesting run can be repeated
+      if (options.verbose) cout << ". Seed:         " << ic3.seed << endl;
+    }
+    ic3.ternary = options.ternary;
+    ic3.liftRatio = options.liftRatio;
+    ic3.limits = options.limits;
+    ic3.json = options.json;
+    ic3.jsonPerLevel = options.jsonPerLevel;
+    ic3.adaptive = options.adaptive;
+    ic3.trace = options.trace;
+    ic3.share = options.share;
+    ic3.shareMaxSize = options.shareMaxSize;
+    ic3.progress = options.progress;
+    ic3.port = options.lemmas;
+    ic3.obligationPort = options.obligations;
+    ic3.cancel = options.cancel;
+    ic3.startWindow();
+    Result rv;
+    bool base = false;  // a base case fails
+    try {
+      ic3.startWatchdog();
+      if (!ic3.baseCases(outcome ? &outcome->witness : NULL))
+        base = true;
+      else {
+        if (options.frames) ic3.restore(*options.frames);
+        rv = ic3.check() ? Safe : Unsafe;
+      }
+    }
+    catch (const IC3::OutOfBudget & e) {
+      // report how far it got, even if not asked for statistics,
+      // unless the caller takes the outcome
+      if (!outcome) {
+        if (string(e.what) == "cancel")
+          cout << ". Cancelled at K = " << ic3.k << endl;
+        else
+          cout << ". Out of " << e.what << " at K = " << ic3.k << endl;
+        ic3.verbose = max(ic3.verbose, 1);
+      }
+      else
+        outcome->stopped = e.what;
+      rv = Unknown;
+    }
+    ic3.stopWatchdog();
+    if (base) {
+      if (options.json) 
+        *options.json << "{\"result\":\"unsafe\",\"k\":0}" << endl;
+      if (outcome) {
+        outcome->result = Unsafe;
+        outcome->queries = ic3.nQuery;
+        outcome->seconds = (nanotime() - start) / 1e9;
+      }
+      return Unsafe;
+    }
+    if (rv == Unsafe && options.verbose > 1) ic3.printWitness();
+    if (ic3.verbose) ic3.printStats();
+    if (options.json) {
+      static const char * names[] = { "safe", "unsafe", "unknown" };
+      ic3.writeJson(*options.json, names[rv]);
+    }
+    if (outcome) {
+      outcome->result = rv;
+      if (rv == Unsafe) ic3.witness(outcome->witness);
+      if (rv == Safe) ic3.invariant(outcome->invariant);
+      ic3.lemmas(outcome->lemmas);
+      outcome->k = ic3.k;
+      outcome->queries = ic3.nQuery;
+      outcome->seconds = (nanotime() - start) / 1e9;
+    }
     return rv;
   }
 
+  void microbench(Model & model, size_t reps, size_t cubeSize, 
+                  unsigned int seed, vector<Timings> & timings) {
+    IC3 ic3(model);
+    ic3.seed = seed;
+    model.lockPrimes();
+    ic3.microbench(reps, cubeSize, timings);
+  }
+
 }
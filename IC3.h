@@ -24,14 +24,182 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef IC3_h_INCLUDED
 #define IC3_h_INCLUDED
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+
 #include "Model.h"
 
+namespace Trace { class Writer; }
+
 namespace IC3 {
 
-  bool check(Model & model, 
-             int verbose = 0,       // 0: silent, 1: stats, 2: informative
-             bool basic = false,    // simple inductive generalization
-             bool random = false);  // random runs for statistical profiling
+  // Verdicts, numbered as in the AIGER result format.
+  enum Result { Safe = 0, Unsafe = 1, Unknown = 2 };
+
+  // Resource budgets, where 0 means unlimited.  When one runs out,
+  // check() gives up with Unknown.
+  struct Limits {
+    Limits() : seconds(0), conflicts(0), memoryMB(0) {}
+    double seconds;      // wall-clock time
+    uint64_t conflicts;  // SAT conflicts over all solvers
+    size_t memoryMB;     // resident set size
+  };
+
+  // Live statistics, passed to Options::progress after each level.
+  struct Progress {
+    Progress() : k(0), seconds(0), queries(0), conflicts(0), ctis(0),
+                 ctgs(0) {}
+    size_t k;            // the level just finished
+    double seconds;      // wall-clock time so far
+    uint64_t queries, conflicts, ctis, ctgs;
+    vector<size_t> lemmas;  // per frame 1 .. k+1, of those kept in it
+  };
+
+  // Stops check()s from another thread: after cancel(), each check()
+  // using the token gives up with Unknown, interrupting its running
+  // SAT query.
+  class CancelToken {
+  public:
+    CancelToken() : flag(false) {}
+    void cancel();
+    bool cancelled() const { return flag; }
+    // ... so that the token can serve further checks
+    void reset() { flag = false; }
+
+  private:
+    friend class IC3;
+    // Registers a solver about to run a query; returns false, without
+    // registering it, if the token is cancelled.
+    bool attach(SatSolver * slv);
+    void detach(SatSolver * slv);
+
+    atomic<bool> flag;
+    mutex mtx;
+    vector<SatSolver *> running;  // of all checks using the token
+  };
+
+  // A lemma: a cube that no state reachable within level steps is in.
+  struct Lemma {
+    size_t level;
+    LitVec cube;
+  };
+
+  // Exchanges lemmas with other checks of the same property of the
+  // same AIGER model, e.g., in other processes (see Cluster.h).
+  // check() calls both on its own thread.
+  class LemmaPort {
+  public:
+    virtual ~LemmaPort() {}
+    // Called with each lemma that the check learns or pushes.
+    virtual void publish(const Lemma & lemma) = 0;
+    // Called at each level and CTI; appends the lemmas received since
+    // the last call.  check() adds each one that it can confirm to
+    // be inductive relative to its own frame below the lemma's level.
+    virtual void receive(vector<Lemma> & lemmas) = 0;
+  };
+
+  // A step of a counterexample: the values of the inputs, and of
+  // those latches that matter, in that step; the other latches may
+  // take any value that the previous step leads to.
+  struct Step {
+    LitVec inputs, latches;
+  };
+
+  // Receives a check's proof obligations as they arise, e.g., to
+  // look for a state that a check in the other direction has reached
+  // (see Reverse.h).  check() calls it on its own thread, once per
+  // obligation, with the steps from the obligation's state to the
+  // error in the format of Outcome::witness.
+  class ObligationPort {
+  public:
+    virtual ~ObligationPort() {}
+    virtual void obligation(const vector<Step> & chain) = 0;
+  };
+
+  // Everything check() can be tuned by.  The defaults are those of
+  // the command line.
+  struct Options {
+    Options() : verbose(0), basic(false), random(false), seed(0),
+                ternary(false), liftRatio(0.75), adaptive(false),
+                share(false), shareMaxSize(8),
+                maxDepth(1), maxCTGs(3), maxJoins(1<<20), micAttempts(3),
+                json(NULL), jsonPerLevel(false), trace(NULL), cancel(NULL),
+                lemmas(NULL), frames(NULL), obligations(NULL) {}
+    int verbose;         // 0: silent, 1: stats, 2: informative
+    bool basic;          // simple inductive generalization: no CTGs or
+                         // joins, whatever the knobs below say
+    bool random;         // random runs for statistical profiling
+    unsigned int seed;   // with random: 0 picks one
+    bool ternary;        // lift CTIs by ternary simulation, falling back
+    float liftRatio;     // ... to SAT if more than this fraction of
+                         // latches remain
+    bool adaptive;       // tune the knobs below per level
+    bool share;          // share learned clauses implied by the TR
+    size_t shareMaxSize; // ... of at most this many literals
+
+    // generalization knobs (see IC3.cpp)
+    size_t maxDepth;     // depth of CTG recursion
+    size_t maxCTGs;      // CTGs handled per literal drop
+    size_t maxJoins;     // joins with CTGs per literal drop
+    size_t micAttempts;  // failed literal drops before mic() gives up
+
+    Limits limits;
+    ostream * json;         // statistics as JSON
+    bool jsonPerLevel;      // ... after each level, too
+    Trace::Writer * trace;  // binary event trace
+    // Called after each level on check()'s thread; it must not call
+    // back into the check, but it may cancel it.
+    function<void (const Progress &)> progress;
+    CancelToken * cancel;
+    LemmaPort * lemmas;
+    // Lemmas to start from, e.g., Outcome::lemmas of a check of a
+    // model that this one refines: one over the same latches, and
+    // perhaps more, whose initial states and transitions are among
+    // the other's (see Abstraction.h).  They are added unchecked, and
+    // the check resumes at the level below the highest of them.
+    const vector<Lemma> * frames;
+    ObligationPort * obligations;
+  };
+
+  // What check() found, and the headline numbers of the run.
+  struct Outcome {
+    Outcome() : result(Unknown), k(0), queries(0), seconds(0) {}
+    Result result;
+    // Unsafe: the steps from an initial state, where the last one
+    // violates the property.
+    vector<Step> witness;
+    // Safe: cubes whose negations, together with the property and the
+    // invariant constraints, form an inductive invariant.
+    vector<LitVec> invariant;
+    // The lemmas of all frames, each at the highest level it is in.
+    vector<Lemma> lemmas;
+    // Unknown: the budget that ran out ("time", "conflicts", or
+    // "memory"), or "cancel".
+    string stopped;
+    size_t k;          // frontier level reached
+    uint64_t queries;  // SAT queries
+    double seconds;    // wall-clock time
+  };
+
+  // Checks the model's property.  Fills outcome if given, in which
+  // case running out of budget is not reported on stdout.
+  Result check(Model & model, const Options & options = Options(),
+               Outcome * outcome = NULL);
+
+  // Latency samples (ns) of one operation.
+  struct Timings {
+    Timings(const string & _name) : name(_name) {}
+    string name;
+    vector<uint64_t> ns;
+  };
+
+  // Micro-benchmarks of the engine's core operations on fixed random
+  // cubes of cubeSize latches (see bench/micro.cpp): consecution
+  // relative to F_1, stateOf (lifting) of predecessors, and addCube.
+  // Appends reps samples per operation to timings.
+  void microbench(Model & model, size_t reps, size_t cubeSize, 
+                  unsigned int seed, vector<Timings> & timings);
 
 }
 
@@ -25,10 +25,9 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "Model.h"
 #include "SimpSolver.h"
+#include "Stats.h"
 #include "Vec.h"
 
-Minisat::Var Var::gvi = 0;
-
 Model::~Model() {
   if (inits) delete inits;
   if (sslv) delete sslv;
@@ -52,7 +51,7 @@ const Var & Model::primeVar(const Var & v, Minisat::SimpSolver * slv) {
     stringstream ss;
     ss << v.name() << "'";
     index = vars.size();
-    vars.push_back(Var(ss.str()));
+    vars.push_back(Var(vars.size(), ss.str()));
     if (slv) {
       Minisat::Var _v = slv->newVar();
       assert (_v == vars.back().var());
@@ -65,8 +64,9 @@ const Var & Model::primeVar(const Var & v, Minisat::SimpSolver * slv) {
   return vars[index];
 }
 
-Minisat::Solver * Model::newSolver() const {
-  Minisat::Solver * slv = new Minisat::Solver();
+SatSolver * Model::newSolver() const {
+  SatSolver * slv = newSatSolver(backend);
+  assert (slv);
   // load all variables to maintain alignment
   for (size_t i = 0; i < vars.size(); ++i) {
     Minisat::Var nv = slv->newVar();
@@ -75,7 +75,165 @@ Minisat::Solver * Model::newSolver() const {
   return slv;
 }
 
-void Model::loadTransitionRelation(Minisat::Solver & slv, bool primeConstraints) {
+bool Model::setSatBackend(const string & name) {
+  SatSolver * slv = newSatSolver(name);
+  if (!slv) return false;
+  delete slv;
+  backend = name;
+  return true;
+}
+
+bool Model::setEncoding(const string & name) {
+  if (name != "tseitin" && name != "compact") return false;
+  if (sslv && compact != (name == "compact")) return false;
+  compact = name == "compact";
+  return true;
+}
+
+void Model::clausify(const LitVec & roots, vector<LitVec> & clauses, 
+                     CNFStats * stats) const {
+  // collect the required rows, outputs first
+  LitSet require(roots.begin(), roots.end());
+  vector<const AigRow *> rows;
+  for (AigVec::const_reverse_iterator i = aig.rbegin(); i != aig.rend(); ++i) {
+    if (require.find(i->lhs) == require.end() 
+        && require.find(~i->lhs) == require.end())
+      continue;
+    rows.push_back(&*i);
+    require.insert(i->rhs0);
+    require.insert(i->rhs1);
+  }
+  LitVec cls;
+  if (!compact) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const AigRow & r = *rows[i];
+      cls.assign(1, ~r.lhs);  cls.push_back(r.rhs0);  clauses.push_back(cls);
+      cls.assign(1, ~r.lhs);  cls.push_back(r.rhs1);  clauses.push_back(cls);
+      cls.assign(1, ~r.rhs0); cls.push_back(~r.rhs1); cls.push_back(r.lhs);
+      clauses.push_back(cls);
+    }
+    return;
+  }
+
+  // An AND whose only reference is from one other required row can
+  // be folded into that row's gate: its variable is then left out of
+  // the CNF, along with its three clauses.  Roots are referenced from
+  // outside, so they are never folded.
+  unordered_map<size_t, const AigRow *> rowOf;
+  unordered_map<size_t, size_t> refs;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    rowOf[(size_t) var(rows[i]->lhs)] = rows[i];
+    ++refs[(size_t) var(rows[i]->rhs0)];
+    ++refs[(size_t) var(rows[i]->rhs1)];
+  }
+  for (LitVec::const_iterator i = roots.begin(); i != roots.end(); ++i)
+    refs[(size_t) var(*i)] += 2;
+  auto foldable = [&](Minisat::Lit l) {
+    return rowOf.find((size_t) var(l)) != rowOf.end() 
+      && refs[(size_t) var(l)] == 1;
+  };
+  unordered_map<size_t, bool> folded;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const AigRow & r = *rows[i];
+    if (folded[(size_t) var(r.lhs)]) continue;
+    // multiplexer: lhs = ~(s & t) & ~(~s & e), i.e., ~lhs = s ? t : e,
+    // which is an XOR if t = ~e
+    if (sign(r.rhs0) && sign(r.rhs1) && foldable(r.rhs0) 
+        && foldable(r.rhs1)) {
+      const AigRow & x = *rowOf[(size_t) var(r.rhs0)], 
+        & y = *rowOf[(size_t) var(r.rhs1)];
+      Minisat::Lit xs[2] = { x.rhs0, x.rhs1 }, ys[2] = { y.rhs0, y.rhs1 };
+      int xi = -1, yi = -1;
+      for (int a = 0; a < 2 && xi < 0; ++a)
+        for (int b = 0; b < 2 && xi < 0; ++b)
+          if (xs[a] == ~ys[b]) {
+            xi = a;
+            yi = b;
+          }
+      if (xi >= 0) {
+        Minisat::Lit m = ~r.lhs, s = xs[xi], t = xs[1-xi], e = ys[1-yi];
+        folded[(size_t) var(x.lhs)] = folded[(size_t) var(y.lhs)] = true;
+        cls.assign(1, ~s); cls.push_back(~t); cls.push_back(m);
+        clauses.push_back(cls);
+        cls.assign(1, ~s); cls.push_back(t);  cls.push_back(~m);
+        clauses.push_back(cls);
+        cls.assign(1, s);  cls.push_back(~e); cls.push_back(m);
+        clauses.push_back(cls);
+        cls.assign(1, s);  cls.push_back(e);  cls.push_back(~m);
+        clauses.push_back(cls);
+        if (t == ~e) {
+          if (stats) ++stats->xors;
+          continue;
+        }
+        // redundant, but they let propagation see through s
+        cls.assign(1, ~t); cls.push_back(~e); cls.push_back(m);
+        clauses.push_back(cls);
+        cls.assign(1, t);  cls.push_back(e);  cls.push_back(~m);
+        clauses.push_back(cls);
+        if (stats) ++stats->muxes;
+        continue;
+      }
+    }
+    // multi-input AND over the leaves of the tree of foldable,
+    // unnegated inputs
+    LitVec leaves, stack;
+    stack.push_back(r.rhs0);
+    stack.push_back(r.rhs1);
+    while (!stack.empty()) {
+      Minisat::Lit l = stack.back();
+      stack.pop_back();
+      if (!sign(l) && foldable(l)) {
+        const AigRow & c = *rowOf[(size_t) var(l)];
+        folded[(size_t) var(l)] = true;
+        stack.push_back(c.rhs0);
+        stack.push_back(c.rhs1);
+        if (stats) ++stats->collapsed;
+      }
+      else
+        leaves.push_back(l);
+    }
+    sort(leaves.begin(), leaves.end());
+    leaves.erase(unique(leaves.begin(), leaves.end()), leaves.end());
+    if (stats) ++stats->ands;
+    // complementary leaves, which sort next to each other
+    bool contradictory = false;
+    for (size_t j = 1; j < leaves.size(); ++j)
+      if (leaves[j] == ~leaves[j-1]) contradictory = true;
+    if (contradictory) {
+      clauses.push_back(LitVec(1, ~r.lhs));
+      continue;
+    }
+    cls.assign(1, r.lhs);
+    for (size_t j = 0; j < leaves.size(); ++j) {
+      clauses.push_back(LitVec(1, ~r.lhs));
+      clauses.back().push_back(leaves[j]);
+      cls.push_back(~leaves[j]);
+    }
+    clauses.push_back(cls);
+  }
+}
+
+// Counts the variables and clauses of the solver, including units.
+static void countCNF(Minisat::SimpSolver & slv, size_t & vars, 
+                     size_t & clauses) {
+  vector<bool> seen(slv.nVars(), false);
+  vars = clauses = 0;
+  for (Minisat::ClauseIterator c = slv.clausesBegin(); 
+       c != slv.clausesEnd(); ++c, ++clauses)
+    for (int i = 0; i < (*c).size(); ++i)
+      if (!seen[var((*c)[i])]) {
+        seen[var((*c)[i])] = true;
+        ++vars;
+      }
+  for (Minisat::TrailIterator c = slv.trailBegin(); 
+       c != slv.trailEnd(); ++c, ++clauses)
+    if (!seen[var(*c)]) {
+      seen[var(*c)] = true;
+      ++vars;
+    }
+}
+
+void Model::loadTransitionRelation(SatSolver & slv, bool primeConstraints) {
   if (!sslv) {
     // create a simplified CNF version of (this slice of) the TR
     sslv = new Minisat::SimpSolver();
@@ -101,43 +259,67 @@ void Model::loadTransitionRelation(Minisat::Solver & slv, bool primeConstraints)
       sslv->setFrozen(v.var(), true);
       sslv->setFrozen(primeVar(v).var(), true);
     }
-    // initialize with roots of required formulas
-    LitSet require;  // unprimed formulas
-    for (VarVec::const_iterator i = beginLatches(); i != endLatches(); ++i)
-      require.insert(nextStateFn(*i));
-    require.insert(_error);
-    require.insert(constraints.begin(), constraints.end());
-    LitSet prequire; // for primed formulas; always subset of require
-    prequire.insert(_error);
-    prequire.insert(constraints.begin(), constraints.end());
-    // traverse AIG backward
-    for (AigVec::const_reverse_iterator i = aig.rbegin(); 
-         i != aig.rend(); ++i) {
-      // skip if this row is not required
-      if (require.find(i->lhs) == require.end() 
-          && require.find(~i->lhs) == require.end())
-        continue;
-      // encode into CNF
-      sslv->addClause(~i->lhs, i->rhs0);
-      sslv->addClause(~i->lhs, i->rhs1);
-      sslv->addClause(~i->rhs0, ~i->rhs1, i->lhs);
-      // require arguments
-      require.insert(i->rhs0);
-      require.insert(i->rhs1);
-      // primed: skip if not required
-      if (prequire.find(i->lhs) == prequire.end()
-          && prequire.find(~i->lhs) == prequire.end())
-        continue;
-      // encode PRIMED form into CNF
-      Minisat::Lit r0 = primeLit(i->lhs, sslv), 
-        r1 = primeLit(i->rhs0, sslv), 
-        r2 = primeLit(i->rhs1, sslv);
-      sslv->addClause(~r0, r1);
-      sslv->addClause(~r0, r2);
-      sslv->addClause(~r1, ~r2, r0);
-      // require arguments
-      prequire.insert(i->rhs0);
-      prequire.insert(i->rhs1);
+    if (compact) {
+      // the cones of the next-state functions, error, and constraints,
+      // and the primed cones of the error and constraints
+      LitVec roots, proots;
+      for (VarVec::const_iterator i = beginLatches(); i != endLatches(); ++i)
+        roots.push_back(nextStateFn(*i));
+      proots.push_back(_error);
+      proots.insert(proots.end(), constraints.begin(), constraints.end());
+      roots.insert(roots.end(), proots.begin(), proots.end());
+      vector<LitVec> clauses;
+      clausify(roots, clauses, &cnfCounts);
+      size_t unprimed = clauses.size();
+      clausify(proots, clauses);
+      Minisat::vec<Minisat::Lit> cls;
+      for (size_t i = 0; i < clauses.size(); ++i) {
+        cls.clear();
+        for (LitVec::const_iterator j = clauses[i].begin(); 
+             j != clauses[i].end(); ++j)
+          cls.push(i < unprimed ? *j : primeLit(*j, sslv));
+        sslv->addClause(cls);
+      }
+    }
+    else {
+      // initialize with roots of required formulas
+      LitSet require;  // unprimed formulas
+      for (VarVec::const_iterator i = beginLatches(); i != endLatches(); ++i)
+        require.insert(nextStateFn(*i));
+      require.insert(_error);
+      require.insert(constraints.begin(), constraints.end());
+      LitSet prequire; // for primed formulas; always subset of require
+      prequire.insert(_error);
+      prequire.insert(constraints.begin(), constraints.end());
+      // traverse AIG backward
+      for (AigVec::const_reverse_iterator i = aig.rbegin(); 
+           i != aig.rend(); ++i) {
+        // skip if this row is not required
+        if (require.find(i->lhs) == require.end() 
+            && require.find(~i->lhs) == require.end())
+          continue;
+        // encode into CNF
+        sslv->addClause(~i->lhs, i->rhs0);
+        sslv->addClause(~i->lhs, i->rhs1);
+        sslv->addClause(~i->rhs0, ~i->rhs1, i->lhs);
+        // require arguments
+        require.insert(i->rhs0);
+        require.insert(i->rhs1);
+        // primed: skip if not required
+        if (prequire.find(i->lhs) == prequire.end()
+            && prequire.find(~i->lhs) == prequire.end())
+          continue;
+        // encode PRIMED form into CNF
+        Minisat::Lit r0 = primeLit(i->lhs, sslv), 
+          r1 = primeLit(i->rhs0, sslv), 
+          r2 = primeLit(i->rhs1, sslv);
+        sslv->addClause(~r0, r1);
+        sslv->addClause(~r0, r2);
+        sslv->addClause(~r1, ~r2, r0);
+        // require arguments
+        prequire.insert(i->rhs0);
+        prequire.insert(i->rhs1);
+      }
     }
     // assert literal for true
     sslv->addClause(btrue());
@@ -153,7 +335,11 @@ void Model::loadTransitionRelation(Minisat::Solver & slv, bool primeConstraints)
       sslv->addClause(~platch, f);
       sslv->addClause(~f, platch);
     }
+    countCNF(*sslv, cnfCounts.vars, cnfCounts.clauses);
+    uint64_t start = nanotime();
     sslv->eliminate(true);
+    cnfCounts.elimNs = nanotime() - start;
+    countCNF(*sslv, cnfCounts.simpVars, cnfCounts.simpClauses);
   }
   // load the clauses from the simplified context
   while (slv.nVars() < sslv->nVars()) slv.newVar();
@@ -163,7 +349,7 @@ void Model::loadTransitionRelation(Minisat::Solver & slv, bool primeConstraints)
     Minisat::vec<Minisat::Lit> cls_;
     for (int i = 0; i < cls.size(); ++i)
       cls_.push(cls[i]);
-    slv.addClause_(cls_);
+    slv.addClause(cls_);
   }
   for (Minisat::TrailIterator c = sslv->trailBegin(); 
        c != sslv->trailEnd(); ++c)
@@ -174,79 +360,266 @@ void Model::loadTransitionRelation(Minisat::Solver & slv, bool primeConstraints)
       slv.addClause(primeLit(*i));
 }
 
-void Model::loadInitialCondition(Minisat::Solver & slv) const {
+static void addClauses(SatSolver & slv, const vector<LitVec> & clauses) {
+  Minisat::vec<Minisat::Lit> cls;
+  for (size_t i = 0; i < clauses.size(); ++i) {
+    cls.clear();
+    for (LitVec::const_iterator j = clauses[i].begin(); 
+         j != clauses[i].end(); ++j)
+      cls.push(*j);
+    slv.addClause(cls);
+  }
+}
+
+void Model::loadInitialCondition(SatSolver & slv) const {
   slv.addClause(btrue());
   for (LitVec::const_iterator i = init.begin(); i != init.end(); ++i)
     slv.addClause(*i);
   if (constraints.empty())
     return;
   // impose invariant constraints on initial states (AIGER 1.9)
-  LitSet require;
-  require.insert(constraints.begin(), constraints.end());
-  for (AigVec::const_reverse_iterator i = aig.rbegin(); i != aig.rend(); ++i) {
-    // skip if this (*i) is not required
-    if (require.find(i->lhs) == require.end() 
-        && require.find(~i->lhs) == require.end())
-      continue;
-    // encode into CNF
-    slv.addClause(~i->lhs, i->rhs0);
-    slv.addClause(~i->lhs, i->rhs1);
-    slv.addClause(~i->rhs0, ~i->rhs1, i->lhs);
-    // require arguments
-    require.insert(i->rhs0);
-    require.insert(i->rhs1);
-  }
+  vector<LitVec> clauses;
+  clausify(constraints, clauses);
+  addClauses(slv, clauses);
   for (LitVec::const_iterator i = constraints.begin(); 
        i != constraints.end(); ++i)
     slv.addClause(*i);
 }
 
-void Model::loadError(Minisat::Solver & slv) const {
-  LitSet require;  // unprimed formulas
-  require.insert(_error);
-  // traverse AIG backward
+void Model::loadError(SatSolver & slv) const {
+  vector<LitVec> clauses;
+  clausify(LitVec(1, _error), clauses);
+  addClauses(slv, clauses);
+}
+
+void Model::prepareInit() {
+  initPrepared = true;
+  initForced.assign(primes, Minisat::l_Undef);
+  initForced[0] = Minisat::l_False;
+  for (LitVec::const_iterator i = init.begin(); i != init.end(); ++i)
+    initForced[var(*i)] = Minisat::lbool(!sign(*i));
+  if (constraints.empty()) return;
+
+  inits = newSolver();
+  loadInitialCondition(*inits);
+  initSat = inits->solve() == Minisat::l_True;
+  if (!initSat) return;
+  // The backbone: latches that the constraints force.  A candidate
+  // is dropped as soon as some initial state disagrees with its
+  // value in the first one.
+  vector<pair<Minisat::Var, Minisat::lbool> > cands;
+  for (VarVec::const_iterator i = beginLatches(); i != endLatches(); ++i)
+    if (initForced[i->index()] == Minisat::l_Undef)
+      cands.push_back(make_pair(i->var(), inits->modelValue(i->var())));
+  vector<bool> dropped(cands.size(), false);
+  for (size_t c = 0; c < cands.size(); ++c) {
+    if (dropped[c]) continue;
+    Minisat::Lit other = Minisat::mkLit(cands[c].first, 
+                                        cands[c].second == Minisat::l_True);
+    if (inits->solve(other) == Minisat::l_True) {
+      for (size_t d = c; d < cands.size(); ++d)
+        if (inits->modelValue(cands[d].first) != cands[d].second)
+          dropped[d] = true;
+    }
+    else
+      initForced[cands[c].first] = cands[c].second;
+  }
+
+  // the constraints' cone, in order
+  LitSet require;
+  require.insert(constraints.begin(), constraints.end());
   for (AigVec::const_reverse_iterator i = aig.rbegin(); i != aig.rend(); ++i) {
-    // skip if this row is not required
     if (require.find(i->lhs) == require.end() 
         && require.find(~i->lhs) == require.end())
       continue;
-    // encode into CNF
-    slv.addClause(~i->lhs, i->rhs0);
-    slv.addClause(~i->lhs, i->rhs1);
-    slv.addClause(~i->rhs0, ~i->rhs1, i->lhs);
-    // require arguments
+    initCone.push_back(*i);
     require.insert(i->rhs0);
     require.insert(i->rhs1);
   }
+  reverse(initCone.begin(), initCone.end());
+}
+
+Minisat::lbool Model::ternaryInit(const LitVec & latches) {
+  // forced values, the cube, and X elsewhere
+  initVals = initForced;
+  for (LitVec::const_iterator i = latches.begin(); i != latches.end(); ++i)
+    initVals[var(*i)] = Minisat::lbool(!sign(*i));
+  for (AigVec::const_iterator i = initCone.begin(); i != initCone.end(); ++i)
+    initVals[var(i->lhs)] = 
+      (initVals[var(i->rhs0)] ^ sign(i->rhs0)) 
+      && (initVals[var(i->rhs1)] ^ sign(i->rhs1));
+  Minisat::lbool rv = Minisat::l_True;
+  for (LitVec::const_iterator i = constraints.begin(); 
+       i != constraints.end(); ++i) {
+    Minisat::lbool v = initVals[var(*i)] ^ sign(*i);
+    if (v == Minisat::l_False) return Minisat::l_False;
+    if (v == Minisat::l_Undef) rv = Minisat::l_Undef;
+  }
+  return rv;
 }
 
 bool Model::isInitial(const LitVec & latches) {
-  if (constraints.empty()) {
-    // an intersection check (AIGER 1.9 w/o invariant constraints)
-    if (initLits.empty())
-      initLits.insert(init.begin(), init.end());
-    for (LitVec::const_iterator i = latches.begin(); i != latches.end(); ++i)
-      if (initLits.find(~*i) != initLits.end())
-        return false;
+  ++initCounts.calls;
+  if (!initPrepared) prepareInit();
+  if (!initSat) {
+    // no initial states at all
+    ++initCounts.syntactic;
+    return false;
+  }
+  // A literal that contradicts a forced value rules out every
+  // initial state; if all literals agree with forced values, every
+  // initial state is in the cube.  Without invariant constraints,
+  // latches without initial values are free, so this check is exact
+  // (an intersection check, AIGER 1.9).
+  bool allForced = true;
+  for (LitVec::const_iterator i = latches.begin(); i != latches.end(); ++i) {
+    Minisat::lbool f = initForced[var(*i)];
+    if (f == Minisat::l_Undef)
+      allForced = false;
+    else if ((f ^ sign(*i)) == Minisat::l_False) {
+      ++initCounts.syntactic;
+      return false;
+    }
+  }
+  if (allForced || constraints.empty()) {
+    ++initCounts.syntactic;
     return true;
   }
-  else {
-    // a full SAT query
-    if (!inits) {
-      inits = newSolver();
-      loadInitialCondition(*inits);
+  // Ternary simulation of the constraints under the cube: all true
+  // means any completion is an initial state; one false, none is.
+  Minisat::lbool t = ternaryInit(latches);
+  if (t != Minisat::l_Undef) {
+    ++initCounts.ternary;
+    return t == Minisat::l_True;
+  }
+  // The answer depends only on the literals without forced values.
+  LitVec key;
+  for (LitVec::const_iterator i = latches.begin(); i != latches.end(); ++i)
+    if (initForced[var(*i)] == Minisat::l_Undef) key.push_back(*i);
+  sort(key.begin(), key.end());
+  InitMemo::const_iterator m = initMemo.find(key);
+  if (m != initMemo.end()) {
+    ++initCounts.memo;
+    return m->second;
+  }
+  // a full SAT query
+  ++initCounts.sat;
+  Minisat::vec<Minisat::Lit> assumps;
+  assumps.capacity(key.size());
+  for (LitVec::const_iterator i = key.begin(); i != key.end(); ++i)
+    assumps.push(*i);
+  bool rv = inits->solve(assumps) == Minisat::l_True;
+  if (initMemo.size() >= (1 << 16)) initMemo.clear();
+  initMemo[key] = rv;
+  return rv;
+}
+
+void Model::buildSimNetwork() {
+  simRows.assign(aig.begin(), aig.end());
+  // l' = f & true for each latch l
+  for (VarVec::const_iterator i = beginLatches(); i != endLatches(); ++i)
+    simRows.push_back(AigRow(primeLit(i->lit(false)), nextStateFn(*i), 
+                             btrue()));
+  // primed rows for the primed cones of the error and constraints.
+  // The compact encoding primes only the ANDs that survive folding, and
+  // the primes are locked by now, so the others get indices past the
+  // variables, which only the simulation sees.
+  vector<bool> cone(primes, false);
+  cone[varOfLit(_error).index()] = true;
+  for (LitVec::const_iterator i = constraints.begin(); 
+       i != constraints.end(); ++i)
+    cone[varOfLit(*i).index()] = true;
+  for (AigVec::const_reverse_iterator i = aig.rbegin(); i != aig.rend(); ++i)
+    if (cone[varOfLit(i->lhs).index()]) {
+      cone[varOfLit(i->rhs0).index()] = true;
+      cone[varOfLit(i->rhs1).index()] = true;
+    }
+  IndexMap simPrimes;
+  size_t simVars = vars.size();
+  for (AigVec::const_iterator i = aig.begin(); i != aig.end(); ++i) {
+    size_t index = varOfLit(i->lhs).index();
+    if (!cone[index]) continue;
+    IndexMap::const_iterator p = primedAnds.find(index);
+    simPrimes[index] = p != primedAnds.end() ? p->second : simVars++;
+  }
+  for (AigVec::const_iterator i = aig.begin(); i != aig.end(); ++i) {
+    if (!cone[varOfLit(i->lhs).index()]) continue;
+    Minisat::Lit lits[3] = { i->lhs, i->rhs0, i->rhs1 };
+    for (size_t j = 0; j < 3; ++j) {
+      size_t index = varOfLit(lits[j]).index();
+      if (index >= reps)
+        lits[j] = Minisat::mkLit(simPrimes[index], sign(lits[j]));
+      else
+        lits[j] = primeLit(lits[j]);
+    }
+    simRows.push_back(AigRow(lits[0], lits[1], lits[2]));
+  }
+  simFanouts.assign(simVars, vector<size_t>());
+  for (size_t r = 0; r < simRows.size(); ++r) {
+    simFanouts[var(simRows[r].rhs0)].push_back(r);
+    if (var(simRows[r].rhs1) != var(simRows[r].rhs0))
+      simFanouts[var(simRows[r].rhs1)].push_back(r);
+  }
+  simTargets.assign(simVars, false);
+}
+
+bool Model::ternaryLift(const LitVec & assignment, const LitVec & targets, 
+                        const LitVec & order, LitVec & lifted)
+{
+  if (simFanouts.empty()) buildSimNetwork();
+  // simulate the full assignment
+  simVals.assign(simFanouts.size(), Minisat::l_Undef);
+  simVals[0] = Minisat::l_False;
+  for (LitVec::const_iterator i = assignment.begin(); 
+       i != assignment.end(); ++i)
+    simVals[var(*i)] = Minisat::lbool(!sign(*i));
+  for (AigVec::const_iterator i = simRows.begin(); i != simRows.end(); ++i)
+    simVals[var(i->lhs)] = simValue(i->rhs0) && simValue(i->rhs1);
+  for (LitVec::const_iterator i = targets.begin(); i != targets.end(); ++i)
+    if (simValue(*i) != Minisat::l_True)
+      return false;
+  for (LitVec::const_iterator i = targets.begin(); i != targets.end(); ++i)
+    simTargets[var(*i)] = true;
+  // try X for each latch, propagating only through changed fanouts;
+  // values only move toward X, so each variable changes at most once
+  lifted.clear();
+  vector< pair<Minisat::Var, Minisat::lbool> > undo;
+  vector<size_t> stack;
+  for (LitVec::const_iterator i = order.begin(); i != order.end(); ++i) {
+    Minisat::Var v = var(*i);
+    undo.push_back(make_pair(v, simVals[v]));
+    simVals[v] = Minisat::l_Undef;
+    bool justified = !simTargets[v];
+    stack.assign(simFanouts[v].begin(), simFanouts[v].end());
+    while (justified && !stack.empty()) {
+      const AigRow & row = simRows[stack.back()];
+      stack.pop_back();
+      Minisat::Var lv = var(row.lhs);
+      Minisat::lbool nv = simValue(row.rhs0) && simValue(row.rhs1);
+      if (nv == simVals[lv]) continue;
+      undo.push_back(make_pair(lv, simVals[lv]));
+      simVals[lv] = nv;
+      if (simTargets[lv]) 
+        justified = false;
+      else
+        stack.insert(stack.end(), simFanouts[lv].begin(), simFanouts[lv].end());
+    }
+    if (!justified) {
+      // the latch is necessary: restore
+      for (size_t j = undo.size(); j > 0; --j)
+        simVals[undo[j-1].first] = undo[j-1].second;
+      lifted.push_back(*i);
     }
-    Minisat::vec<Minisat::Lit> assumps;
-    assumps.capacity(latches.size());
-    for (LitVec::const_iterator i = latches.begin(); i != latches.end(); ++i)
-      assumps.push(*i);
-    return inits->solve(assumps);
+    undo.clear();
   }
+  for (LitVec::const_iterator i = targets.begin(); i != targets.end(); ++i)
+    simTargets[var(*i)] = false;
+  return true;
 }
 
-// Creates a named variable.
-Var var(const aiger_symbol * syms, size_t i, const char prefix, 
-        bool prime = false)
+// Creates a named variable with the given index.
+Var var(Minisat::Var index, const aiger_symbol * syms, size_t i, 
+        const char prefix, bool prime = false)
 {
   const aiger_symbol & sym = syms[i];
   stringstream ss;
@@ -256,7 +629,7 @@ Var var(const aiger_symbol * syms, size_t i, const char prefix,
     ss << prefix << i;
   if (prime) 
     ss << "'";
-  return Var(ss.str());
+  return Var(index, ss.str());
 }
 
 Minisat::Lit lit(const VarVec & vars, unsigned int l) {
@@ -264,14 +637,14 @@ Minisat::Lit lit(const VarVec & vars, unsigned int l) {
 }
 
 Model * modelFromAiger(aiger * aig, unsigned int propertyIndex) {
-  VarVec vars(1, Var("false"));
+  VarVec vars(1, Var(0, "false"));
   LitVec init, constraints, nextStateFns;
 
   // declare primary inputs and latches
   for (size_t i = 0; i < aig->num_inputs; ++i)
-    vars.push_back(var(aig->inputs, i, 'i'));
+    vars.push_back(var(vars.size(), aig->inputs, i, 'i'));
   for (size_t i = 0; i < aig->num_latches; ++i)
-    vars.push_back(var(aig->latches, i, 'l'));
+    vars.push_back(var(vars.size(), aig->latches, i, 'l'));
 
   // the AND section
   AigVec aigv;
@@ -279,7 +652,7 @@ Model * modelFromAiger(aiger * aig, unsigned int propertyIndex) {
     // 1. create a representative
     stringstream ss;
     ss << 'r' << i;
-    vars.push_back(Var(ss.str()));
+    vars.push_back(Var(vars.size(), ss.str()));
     const Var & rep = vars.back();
     // 2. obtain arguments of AND as lits
     Minisat::Lit l0 = lit(vars, aig->ands[i].rhs0);
@@ -314,9 +687,8 @@ Model * modelFromAiger(aiger * aig, unsigned int propertyIndex) {
     ? lit(vars, aig->bad[propertyIndex].lit) 
     : lit(vars, aig->outputs[propertyIndex].lit);
 
-  size_t offset = 0;
-  return new Model(vars, 
-                   offset += 1, offset += aig->num_inputs, 
-                   offset + aig->num_latches,
+  size_t inputs = 1, latches = inputs + aig->num_inputs, 
+    reps = latches + aig->num_latches;
+  return new Model(vars, inputs, latches, reps,
                    init, constraints, nextStateFns, err, aigv);
 }
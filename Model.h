@@ -25,6 +25,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define MODEL_H_INCLUDED
 
 #include <algorithm>
+#include <map>
 #include <set>
 #include <sstream>
 #include <unordered_map>
@@ -33,7 +34,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 extern "C" {
 #include "aiger.h"
 }
-#include "Solver.h"
+#include "SatSolver.h"
 #include "SimpSolver.h"
 
 // Read it and weep: yes, it's in a header file; no, I don't want to
@@ -51,12 +52,11 @@ typedef vector<AigRow> AigVec;
 typedef vector<Minisat::Lit> LitVec;
 
 // A lightweight wrapper around Minisat::Var that includes a name.
+// Indices are assigned by the owning Model in order of creation, so
+// that they stay aligned with the Model's solvers.
 class Var {
 public:
-  Var(const string name) {
-    _var = gvi++;
-    _name = name;
-  }
+  Var(Minisat::Var var, const string name) : _var(var), _name(name) {}
   size_t index() const { return (size_t) _var; }
   Minisat::Var var() const { return _var; }
   Minisat::Lit lit(bool neg) const {
@@ -64,8 +64,8 @@ public:
   }
   string name() const { return _name; }
 private:
-  static Minisat::Var gvi;  // aligned with solvers
-  Minisat::Var _var;        // corresponding Minisat::Var in *any* solver
+  Minisat::Var _var;  // corresponding Minisat::Var in any of the
+                      // owning Model's solvers
   string _name;
 };
 
@@ -99,13 +99,14 @@ public:
     inputs(_inputs), latches(_latches), reps(_reps),
     primes(_vars.size()), primesUnlocked(true), aig(_aig),
     init(_init), constraints(_constraints), nextStateFns(_nextStateFns),
-    _error(_err), inits(NULL), sslv(NULL)
+    _error(_err), backend("minisat"), inits(NULL), initPrepared(false),
+    initSat(true), sslv(NULL), compact(false)
   {
     // create primed inputs and latches in known region of vars
     for (size_t i = inputs; i < reps; ++i) {
       stringstream ss;
       ss << vars[i].name() << "'";
-      vars.push_back(Var(ss.str()));
+      vars.push_back(Var(vars.size(), ss.str()));
     }
     // same with primed error
     _primedError = primeLit(_error);
@@ -189,9 +190,34 @@ public:
   // Invariant constraints
   const LitVec & invariantConstraints() { return constraints; }
 
-  // Creates a Solver and initializes its variables to maintain
-  // alignment with the Model's variables.
-  Minisat::Solver * newSolver() const;
+  // Creates a solver of the current backend (see SatSolver.h) and
+  // initializes its variables to maintain alignment with the Model's
+  // variables.
+  SatSolver * newSolver() const;
+  // Selects the backend for subsequent newSolver() calls; returns
+  // false if there is no such backend.
+  bool setSatBackend(const string & name);
+  // Selects the CNF encoding of the AND table for subsequent loads:
+  // tseitin (default), three clauses per AND, or compact, which
+  // encodes each tree of single-fanout ANDs as one multi-input AND
+  // and each multiplexer or XOR of three ANDs as one gate.  Returns
+  // false if there is no such encoding or if the TR has already been
+  // built under another.
+  bool setEncoding(const string & name);
+  string encoding() const { return compact ? "compact" : "tseitin"; }
+
+  // The TR's CNF as encoded, i.e., the variables and clauses given to
+  // SimpSolver, and as loaded into solvers after elimination.
+  struct CNFStats {
+    CNFStats() : vars(0), clauses(0), simpVars(0), simpClauses(0), 
+                 elimNs(0), ands(0), collapsed(0), muxes(0), xors(0) {}
+    size_t vars, clauses, simpVars, simpClauses;
+    uint64_t elimNs;  // time spent in elimination
+    // compact: multi-input ANDs, the ANDs collapsed into them, and
+    // multiplexers and XORs (each replacing three ANDs)
+    size_t ands, collapsed, muxes, xors;
+  };
+  const CNFStats & cnfStats() const { return cnfCounts; }
 
   // Loads the TR into the solver.  Also loads the primed error
   // definition such that Model::primedError() need only be asserted
@@ -199,18 +225,37 @@ public:
   // negation of the error are always added --- except that the primed
   // form of the invariant constraints are not asserted if
   // !primeConstraints.
-  void loadTransitionRelation(Minisat::Solver & slv, 
-                              bool primeConstraints = true);
+  void loadTransitionRelation(SatSolver & slv, bool primeConstraints = true);
   // Loads the initial condition into the solver.
-  void loadInitialCondition(Minisat::Solver & slv) const;
+  void loadInitialCondition(SatSolver & slv) const;
   // Loads the error into the solver, which is only necessary for the
   // 0-step base case of IC3.
-  void loadError(Minisat::Solver & slv) const;
+  void loadError(SatSolver & slv) const;
 
   // Use this method to allow the Model to decide how best to decide
   // if a cube has an initial state.
   bool isInitial(const LitVec & latches);
 
+  // How isInitial() decided: by forced initial values (syntactic),
+  // by ternary simulation of the invariant constraints, from memory,
+  // or by a SAT query.
+  struct InitStats {
+    InitStats() : calls(0), syntactic(0), ternary(0), memo(0), sat(0) {}
+    uint64_t calls, syntactic, ternary, memo, sat;
+  };
+  const InitStats & initStats() const { return initCounts; }
+
+  // Ternary (0/1/X) simulation-based lifting.  The assignment gives
+  // values to inputs, primed inputs, and latches; the AND table, the
+  // primed latches, and the primed error and constraints are
+  // simulated from it.  Then each latch of order is set to X in turn,
+  // and the X is kept unless it reaches one of the targets.  Returns
+  // false if the assignment does not make every target true;
+  // otherwise, lifted holds the latches (of order) that remain.  Call
+  // only after loadTransitionRelation().
+  bool ternaryLift(const LitVec & assignment, const LitVec & targets, 
+                   const LitVec & order, LitVec & lifted);
+
 private:
   VarVec vars;
   const size_t inputs, latches, reps, primes;
@@ -228,11 +273,41 @@ private:
   typedef unordered_map<TRMapKey, Minisat::SimpSolver *> TRMap;
   TRMap trmap;
 
-  Minisat::Solver * inits;
-  LitSet initLits;
+  string backend;
+  SatSolver * inits;
+
+  // for isInitial(): the value of each variable in all initial
+  // states, if it has one, and the constraints' AND rows
+  bool initPrepared, initSat;
+  vector<Minisat::lbool> initForced, initVals;
+  AigVec initCone;
+  typedef map<LitVec, bool> InitMemo;
+  InitMemo initMemo;
+  InitStats initCounts;
+  void prepareInit();
+  Minisat::lbool ternaryInit(const LitVec & latches);
 
   Minisat::SimpSolver * sslv;
 
+  bool compact;  // encoding
+  CNFStats cnfCounts;
+  // Appends the CNF of the AND rows in the cone of roots to clauses,
+  // in the current encoding; counts gates in stats, if given.
+  void clausify(const LitVec & roots, vector<LitVec> & clauses, 
+                CNFStats * stats = NULL) const;
+
+  // for ternary simulation: the AND table followed by the primed
+  // latches (as buffers) and the primed AND rows, with fanouts; the
+  // primed ANDs without variables have indices past vars
+  AigVec simRows;
+  vector< vector<size_t> > simFanouts;
+  vector<Minisat::lbool> simVals;
+  vector<bool> simTargets;
+  void buildSimNetwork();
+  Minisat::lbool simValue(Minisat::Lit lit) const {
+    return simVals[var(lit)] ^ sign(lit);
+  }
+
 };
 
 // The easiest way to create a model.
@@ -0,0 +1,111 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef Perf_h_INCLUDED
+#define Perf_h_INCLUDED
+
+// Hardware performance counters (Linux perf_event_open) for the
+// calling thread: cycles, instructions, last-level cache misses, and
+// branch misses, read together as one group.  Only compiled with
+// -DIC3_PERF (make PERF=1); otherwise the engine has no trace of it.
+
+#ifdef IC3_PERF
+
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+class PerfCounters {
+public:
+  enum { Cycles, Instructions, LLCMisses, BranchMisses, NCounters };
+  static const char * name(int c) {
+    static const char * names[] = 
+      { "cycles", "instructions", "llc_misses", "branch_misses" };
+    return names[c];
+  }
+
+  // Counts user-space events of the calling thread from now on.
+  PerfCounters() : leader(-1) {
+    static const uint64_t configs[NCounters] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (int c = 0; c < NCounters; ++c) fds[c] = -1;
+    for (int c = 0; c < NCounters; ++c) {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[c];
+      attr.disabled = c == 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      fds[c] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+      if (fds[c] < 0) {
+        error = strerror(errno);
+        close();
+        return;
+      }
+      if (c == 0) leader = fds[0];
+    }
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+  ~PerfCounters() { close(); }
+
+  bool ok() const { return leader >= 0; }
+  // Why the counters could not be opened.
+  const std::string & why() const { return error; }
+
+  // Current counts, or zeros if unavailable.
+  void read(uint64_t v[NCounters]) const {
+    struct { uint64_t nr, values[NCounters]; } buf;
+    if (!ok() || ::read(leader, &buf, sizeof(buf)) != (ssize_t) sizeof(buf)) {
+      for (int c = 0; c < NCounters; ++c) v[c] = 0;
+      return;
+    }
+    for (int c = 0; c < NCounters; ++c) v[c] = buf.values[c];
+  }
+
+private:
+  void close() {
+    for (int c = NCounters-1; c >= 0; --c)
+      if (fds[c] >= 0) ::close(fds[c]);
+    for (int c = 0; c < NCounters; ++c) fds[c] = -1;
+    leader = -1;
+  }
+
+  int fds[NCounters];
+  int leader;
+  std::string error;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,494 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#include <deque>
+#include <iostream>
+#include <thread>
+
+#include "Reverse.h"
+#include "Model.h"
+#include "Stats.h"
+
+namespace Reverse {
+
+  // The variables of the reversed model, in the canonical AIGER
+  // order:
+  //   Y   inputs: the predecessor of the current state,
+  //   I   inputs: the inputs of the predecessor,
+  //   J   inputs: the inputs of the first state, which violates the
+  //       property,
+  //   X   latches: the current state, uninitialized, with X' = Y,
+  //   F   latch: the first step, initially 1, then 0,
+  //   OK  latch: every step so far, the first state's violation of
+  //       the property and each step from Y to X, was one of the
+  //       concrete model; initially 1,
+  // then the AND table twice, over Y and I and over X and J, and the
+  // ANDs that compare them.  The error is that X is initial and OK
+  // (with the first state's condition, so that 0 steps count).
+  // Checking the steps through the latch OK, rather than through an
+  // invariant constraint, keeps the current state in the cone of the
+  // next one, so that lifting keeps X.
+  struct Map {
+    Map(aiger * aig) : inputs(aig->num_inputs), latches(aig->num_latches) {}
+    unsigned inputs, latches;
+    unsigned Y(unsigned l) const { return 1 + l; }
+    unsigned I(unsigned i) const { return 1 + latches + i; }
+    unsigned J(unsigned i) const { return 1 + latches + inputs + i; }
+    unsigned X(unsigned l) const { return 1 + latches + 2 * inputs + l; }
+    unsigned F() const { return 1 + 2 * latches + 2 * inputs; }
+    unsigned OK() const { return F() + 1; }
+    // the concrete model's variables
+    unsigned input(unsigned i) const { return 1 + i; }
+    unsigned latch(unsigned l) const { return 1 + inputs + l; }
+  };
+
+  // ANDs of the reversed model, with constants folded.
+  struct Builder {
+    Builder(aiger * _aig, unsigned _next) : aig(_aig), next(_next) {}
+    aiger * aig;
+    unsigned next;  // variable of the next AND
+    unsigned conj(unsigned a, unsigned b) {
+      if (a == 0 || b == 0 || a == (b ^ 1)) return 0;
+      if (a == 1 || a == b) return b;
+      if (b == 1) return a;
+      unsigned lhs = 2 * next++;
+      aiger_add_and(aig, lhs, a, b);
+      return lhs;
+    }
+    unsigned equiv(unsigned a, unsigned b) {
+      return conj(conj(a, b ^ 1) ^ 1, conj(a ^ 1, b) ^ 1);
+    }
+  };
+
+  static aiger * reverseAiger(aiger * aig, unsigned propertyIndex, 
+                              const Map & m) {
+    unsigned inputs = aig->num_inputs, latches = aig->num_latches, 
+      ands = aig->num_ands;
+    // the two copies of the AND table: 0 over Y and I, 1 over X and J
+    unsigned base = m.OK() + 1;
+    vector<unsigned> var[2];
+    for (int c = 0; c < 2; ++c) {
+      var[c].resize(aig->maxvar + 1);
+      var[c][0] = 0;
+      for (unsigned i = 0; i < inputs; ++i) 
+        var[c][1 + i] = c ? m.J(i) : m.I(i);
+      for (unsigned l = 0; l < latches; ++l) 
+        var[c][1 + inputs + l] = c ? m.X(l) : m.Y(l);
+      for (unsigned a = 0; a < ands; ++a) 
+        var[c][1 + inputs + latches + a] = base + c * ands + a;
+    }
+    auto lit = [&](int c, unsigned l) { return 2 * var[c][l/2] + (l & 1); };
+
+    aiger * rev = aiger_init();
+    for (unsigned l = 0; l < latches; ++l)
+      aiger_add_input(rev, 2 * m.Y(l), NULL);
+    for (unsigned i = 0; i < inputs; ++i)
+      aiger_add_input(rev, 2 * m.I(i), aig->inputs[i].name);
+    for (unsigned i = 0; i < inputs; ++i)
+      aiger_add_input(rev, 2 * m.J(i), NULL);
+    for (int c = 0; c < 2; ++c)
+      for (unsigned a = 0; a < ands; ++a)
+        aiger_add_and(rev, 2 * (base + c * ands + a), 
+                      lit(c, aig->ands[a].rhs0), lit(c, aig->ands[a].rhs1));
+
+    Builder b(rev, base + 2 * ands);
+    unsigned bad = aig->num_bad > 0 ? aig->bad[propertyIndex].lit 
+      : aig->outputs[propertyIndex].lit;
+    // Y, with I, is a predecessor of X that satisfies the constraints
+    // and does not violate the property, as in the concrete TR
+    unsigned step = lit(0, bad) ^ 1;
+    for (unsigned i = 0; i < aig->num_constraints; ++i)
+      step = b.conj(step, lit(0, aig->constraints[i].lit));
+    for (unsigned l = 0; l < latches; ++l)
+      step = b.conj(step, b.equiv(2 * m.X(l), lit(0, aig->latches[l].next)));
+    // the first state, with J, violates the property
+    unsigned violates = lit(1, bad);
+    for (unsigned i = 0; i < aig->num_constraints; ++i)
+      violates = b.conj(violates, lit(1, aig->constraints[i].lit));
+    unsigned ok = b.conj(2 * m.OK(), b.conj(2 * m.F(), violates ^ 1) ^ 1);
+    unsigned okNext = b.conj(ok, step);
+    unsigned initial = 1;
+    for (unsigned l = 0; l < latches; ++l)
+      if (aig->latches[l].reset < 2)
+        initial = b.conj(initial, 
+                         2 * m.X(l) + (aig->latches[l].reset == 0 ? 1 : 0));
+
+    for (unsigned l = 0; l < latches; ++l) {
+      aiger_add_latch(rev, 2 * m.X(l), 2 * m.Y(l), aig->latches[l].name);
+      aiger_add_reset(rev, 2 * m.X(l), 2 * m.X(l));
+    }
+    aiger_add_latch(rev, 2 * m.F(), 0, "first");
+    aiger_add_reset(rev, 2 * m.F(), 1);
+    aiger_add_latch(rev, 2 * m.OK(), okNext, "ok");
+    aiger_add_reset(rev, 2 * m.OK(), 1);
+    aiger_add_bad(rev, b.conj(initial, ok), NULL);
+    return rev;
+  }
+
+  // Sorts the literals of Y, I, J, and X in lits, as literals of the
+  // concrete model, into y, i, j, and x, where given.
+  static void split(const Map & m, const LitVec & lits, LitVec * y, 
+                    LitVec * i, LitVec * j, LitVec * x) {
+    for (LitVec::const_iterator l = lits.begin(); l != lits.end(); ++l) {
+      unsigned v = (unsigned) Minisat::var(*l), cv;
+      LitVec * out;
+      if (v < m.I(0)) out = y, cv = m.latch(v - m.Y(0));
+      else if (v < m.J(0)) out = i, cv = m.input(v - m.I(0));
+      else if (v < m.X(0)) out = j, cv = m.input(v - m.J(0));
+      else if (v < m.F()) out = x, cv = m.latch(v - m.X(0));
+      else continue;
+      if (out) out->push_back(Minisat::mkLit((Minisat::Var) cv, 
+                                             Minisat::sign(*l)));
+    }
+  }
+
+  // A chain of the reversed model runs from a state back to one
+  // whose predecessor is initial, which it chooses, with its inputs,
+  // as Y and I in the last step.  In reverse, those predecessors are
+  // the steps of the concrete model that lead to the first state.
+  static void predecessors(const Map & m, const vector<IC3::Step> & chain, 
+                           vector<IC3::Step> & steps) {
+    for (size_t t = chain.size() - 1; t-- > 0; ) {
+      steps.push_back(IC3::Step());
+      split(m, chain[t].inputs, &steps.back().latches, &steps.back().inputs, 
+            NULL, NULL);
+    }
+  }
+
+  // The concrete counterexample of one of the reversed model, which
+  // starts in a state violating the property with inputs J.
+  static void forwardWitness(const Map & m, const vector<IC3::Step> & w, 
+                             vector<IC3::Step> & cex) {
+    if (w.empty()) return;
+    if (w.size() > 1) predecessors(m, w, cex);
+    cex.push_back(IC3::Step());
+    split(m, w[0].inputs, NULL, NULL, &cex.back().inputs, NULL);
+    // a 0-step counterexample has no predecessor to follow from
+    if (w.size() == 1) 
+      split(m, w[0].latches, NULL, NULL, NULL, &cex.back().latches);
+  }
+
+  static bool hasProperty(aiger * aig, unsigned propertyIndex) {
+    if ((aig->num_bad > 0 && aig->num_bad <= propertyIndex)
+        || (aig->num_outputs > 0 && aig->num_outputs <= propertyIndex)) {
+      cout << "Bad property index specified." << endl;
+      return false;
+    }
+    return true;
+  }
+
+  static Model * reversedModel(aiger * aig, unsigned propertyIndex, 
+                               const Map & m, const string & backend, 
+                               const string & encoding) {
+    aiger * rev = reverseAiger(aig, propertyIndex, m);
+    Model * model = modelFromAiger(rev, 0);
+    aiger_reset(rev);
+    model->setSatBackend(backend);
+    model->setEncoding(encoding);
+    return model;
+  }
+
+  IC3::Result check(aiger * aig, unsigned int propertyIndex, 
+                    const string & backend, const string & encoding, 
+                    const IC3::Options & options, IC3::Outcome * outcome) {
+    if (outcome) *outcome = IC3::Outcome();
+    if (!hasProperty(aig, propertyIndex)) return IC3::Unknown;
+    Map map(aig);
+    Model * model = reversedModel(aig, propertyIndex, map, backend, encoding);
+    IC3::Options opts = options;
+    opts.lemmas = NULL;
+    opts.frames = NULL;
+    opts.obligations = NULL;
+    IC3::Outcome out;
+    IC3::Result rv = IC3::check(*model, opts, &out);
+    delete model;
+    if (outcome) {
+      vector<IC3::Step> witness;
+      if (rv == IC3::Unsafe) forwardWitness(map, out.witness, witness);
+      out.witness.swap(witness);
+      out.invariant.clear();
+      out.lemmas.clear();
+      *outcome = out;
+    }
+    return rv;
+  }
+
+  // The values of the (primed) variables [begin, end) in slv's model.
+  static void values(Model & model, const SatSolver & slv, 
+                     VarVec::const_iterator begin, VarVec::const_iterator end,
+                     bool primed, LitVec & out) {
+    for (VarVec::const_iterator i = begin; i != end; ++i) {
+      Minisat::Var v = primed ? model.primeVar(*i).var() : i->var();
+      Minisat::lbool val = slv.modelValue(v);
+      if (val != Minisat::l_Undef) 
+        out.push_back(i->lit(val == Minisat::l_False));
+    }
+  }
+
+  // Follows the steps of a forward obligation to the error on the
+  // concrete model from state, a full state in the obligation's cube:
+  // each step asks the TR for a successor of the state reached so far
+  // in the next cube, or, at the end, one that violates the property.
+  // The cubes are lifted, so the successors exist but for invariant
+  // constraints, which lifting takes for granted.
+  static bool follow(Model & concrete, LitVec state, 
+                     const vector<IC3::Step> & chain, 
+                     vector<IC3::Step> & cex) {
+    SatSolver * slv = concrete.newSolver();
+    concrete.loadTransitionRelation(*slv);
+    bool rv = true;
+    for (size_t t = 1; t < chain.size(); ++t) {
+      bool last = t + 1 == chain.size();
+      Minisat::vec<Minisat::Lit> assumps;
+      for (LitVec::const_iterator i = state.begin(); i != state.end(); ++i)
+        assumps.push(*i);
+      if (last) 
+        assumps.push(concrete.primedError());
+      else
+        for (LitVec::const_iterator i = chain[t].latches.begin(); 
+             i != chain[t].latches.end(); ++i)
+          assumps.push(concrete.primeLit(*i));
+      if (slv->solve(assumps) != Minisat::l_True) {
+        rv = false;
+        break;
+      }
+      cex.push_back(IC3::Step());
+      values(concrete, *slv, concrete.beginInputs(), concrete.endInputs(), 
+             false, cex.back().inputs);
+      cex.back().latches = state;
+      if (last) {
+        cex.push_back(IC3::Step());
+        values(concrete, *slv, concrete.beginInputs(), concrete.endInputs(), 
+               true, cex.back().inputs);
+      }
+      else {
+        state.clear();
+        values(concrete, *slv, concrete.beginLatches(), concrete.endLatches(),
+               true, state);
+      }
+    }
+    delete slv;
+    return rv;
+  }
+
+  // Where the two directions meet.  It keeps the most recent
+  // obligations of each direction, up to a budget of literals: the
+  // forward ones as their chains to the error, the backward ones as
+  // the full state that they reach and the concrete steps to it.  A
+  // new obligation is matched against those of the other direction:
+  // a backward state in a forward cube is a counterexample, once the
+  // forward chain is followed from it on the concrete model.
+  class Meeting {
+  public:
+    Meeting(Model & _concrete, const Map & _map, IC3::CancelToken & _cancel)
+      : concrete(_concrete), map(_map), cancel(_cancel), met(false), 
+        forwardLits(0), backwardLits(0), matches(0) {}
+
+    // the chain of a forward obligation
+    void forward(const vector<IC3::Step> & chain) {
+      lock_guard<mutex> lock(mtx);
+      if (met) return;
+      for (deque<Reached>::const_iterator i = reached.begin(); 
+           i != reached.end(); ++i)
+        if (contains(i->values, chain[0].latches) && join(*i, chain)) 
+          return;
+      obligations.push_back(chain);
+      forwardLits += size(chain);
+      while (forwardLits > budget) {
+        forwardLits -= size(obligations.front());
+        obligations.pop_front();
+      }
+    }
+
+    // the chain of a backward obligation, in the reversed model
+    void backward(const vector<IC3::Step> & chain) {
+      lock_guard<mutex> lock(mtx);
+      if (met) return;
+      Reached r;
+      split(map, chain[0].latches, NULL, NULL, NULL, &r.state);
+      if (r.state.size() != map.latches) return;
+      r.values.resize(map.latches);
+      for (LitVec::const_iterator i = r.state.begin(); i != r.state.end(); ++i)
+        r.values[Minisat::var(*i) - map.latch(0)] = !Minisat::sign(*i);
+      predecessors(map, chain, r.steps);
+      for (deque< vector<IC3::Step> >::const_iterator i = obligations.begin();
+           i != obligations.end(); ++i)
+        if (contains(r.values, (*i)[0].latches) && join(r, *i)) 
+          return;
+      reached.push_back(r);
+      backwardLits += r.state.size() + size(r.steps);
+      while (backwardLits > budget) {
+        backwardLits -= reached.front().state.size() 
+          + size(reached.front().steps);
+        reached.pop_front();
+      }
+    }
+
+    bool found() const { return met; }
+    const vector<IC3::Step> & witness() const { return cex; }
+    uint64_t tries() const { return matches; }
+
+  private:
+    static const size_t budget = 1 << 22;  // literals per direction
+
+    struct Reached {
+      LitVec state;
+      vector<bool> values;  // of the latches in state
+      vector<IC3::Step> steps;  // from an initial state to state
+    };
+
+    static size_t size(const vector<IC3::Step> & steps) {
+      size_t n = 0;
+      for (vector<IC3::Step>::const_iterator i = steps.begin(); 
+           i != steps.end(); ++i)
+        n += i->inputs.size() + i->latches.size();
+      return n;
+    }
+
+    bool contains(const vector<bool> & values, const LitVec & cube) const {
+      for (LitVec::const_iterator i = cube.begin(); i != cube.end(); ++i)
+        if (values[Minisat::var(*i) - map.latch(0)] == Minisat::sign(*i))
+          return false;
+      return true;
+    }
+
+    bool join(const Reached & r, const vector<IC3::Step> & chain) {
+      ++matches;
+      vector<IC3::Step> steps(r.steps);
+      if (!follow(concrete, r.state, chain, steps)) return false;
+      cex.swap(steps);
+      met = true;
+      cancel.cancel();
+      return true;
+    }
+
+    mutex mtx;
+    Model & concrete;  // for following, apart from both checks' Models
+    const Map & map;
+    IC3::CancelToken & cancel;
+    bool met;
+    vector<IC3::Step> cex;
+    deque< vector<IC3::Step> > obligations;
+    deque<Reached> reached;
+    size_t forwardLits, backwardLits;
+    uint64_t matches;
+  };
+
+  class Port : public IC3::ObligationPort {
+  public:
+    Port(Meeting & _meeting, bool _backward) : 
+      meeting(_meeting), backward(_backward) {}
+    void obligation(const vector<IC3::Step> & chain) {
+      if (backward) meeting.backward(chain);
+      else meeting.forward(chain);
+    }
+  private:
+    Meeting & meeting;
+    bool backward;
+  };
+
+  IC3::Result bidirectional(aiger * aig, unsigned int propertyIndex, 
+                            const string & backend, const string & encoding, 
+                            const IC3::Options & options, 
+                            IC3::Outcome * outcome) {
+    uint64_t start = nanotime();
+    if (outcome) *outcome = IC3::Outcome();
+    if (!hasProperty(aig, propertyIndex)) return IC3::Unknown;
+    Map map(aig);
+    Model * fwd = modelFromAiger(aig, propertyIndex), 
+      * concrete = modelFromAiger(aig, propertyIndex);
+    fwd->setSatBackend(backend);
+    fwd->setEncoding(encoding);
+    concrete->setSatBackend(backend);
+    concrete->setEncoding(encoding);
+    Model * bwd = reversedModel(aig, propertyIndex, map, backend, encoding);
+
+    IC3::CancelToken cancel;
+    Meeting meeting(*concrete, map, cancel);
+    Port fport(meeting, false), bport(meeting, true);
+    IC3::Options fopts = options, bopts = options;
+    fopts.cancel = bopts.cancel = &cancel;
+    fopts.obligations = &fport;
+    bopts.obligations = &bport;
+    fopts.progress = [&](const IC3::Progress & p) {
+      if (options.cancel && options.cancel->cancelled()) cancel.cancel();
+      if (options.progress) options.progress(p);
+    };
+    // one check's statistics are enough on the shared streams
+    bopts.verbose = 0;
+    bopts.json = NULL;
+    bopts.jsonPerLevel = false;
+    bopts.trace = NULL;
+    bopts.lemmas = NULL;
+    bopts.frames = NULL;
+    bopts.progress = [&](const IC3::Progress &) {
+      if (options.cancel && options.cancel->cancelled()) cancel.cancel();
+    };
+
+    IC3::Outcome fout, bout;
+    IC3::Result brv = IC3::Unknown;
+    thread backward([&]() {
+        brv = IC3::check(*bwd, bopts, &bout);
+        if (brv != IC3::Unknown) cancel.cancel();
+      });
+    IC3::Result frv = IC3::check(*fwd, fopts, &fout);
+    if (frv != IC3::Unknown) cancel.cancel();
+    backward.join();
+
+    IC3::Outcome out;
+    IC3::Result rv = IC3::Unknown;
+    const char * by = "neither";
+    if (frv != IC3::Unknown) {
+      rv = frv;
+      out = fout;
+      by = "forward";
+    }
+    else if (meeting.found()) {
+      rv = IC3::Unsafe;
+      out.witness = meeting.witness();
+      by = "meeting";
+    }
+    else if (brv != IC3::Unknown) {
+      rv = brv;
+      if (rv == IC3::Unsafe) forwardWitness(map, bout.witness, out.witness);
+      by = "backward";
+    }
+    if (options.verbose)
+      cout << ". Directions:   decided by " << by << ", K = " << fout.k 
+           << " forward, " << bout.k << " backward, " << meeting.tries() 
+           << " meetings followed" << endl;
+    delete fwd;
+    delete bwd;
+    delete concrete;
+    if (outcome) {
+      *outcome = out;
+      outcome->result = rv;
+      outcome->lemmas = fout.lemmas;
+      outcome->k = fout.k;
+      outcome->queries = fout.queries + bout.queries;
+      outcome->seconds = (nanotime() - start) / 1e9;
+    }
+    return rv;
+  }
+
+}
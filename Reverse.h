@@ -0,0 +1,75 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef Reverse_h_INCLUDED
+#define Reverse_h_INCLUDED
+
+extern "C" {
+#include "aiger.h"
+}
+#include "IC3.h"
+
+// Backward IC3: IC3 on the reversed model, whose initial states are
+// the states that violate the property and whose error is the
+// initial condition.  Its frames over-approximate the states that
+// reach a violation within i steps, so that lemmas are learned from
+// the error side, which pays off when the error states are few and
+// the initial states are many.  The reversed model is itself an
+// AIGER model (see Reverse.cpp), so the engine, with its frames,
+// generalization, and propagation, runs on it unchanged.
+//
+// The bidirectional mode runs the forward and the backward check on
+// two threads.  Frames cannot prune the other direction's
+// obligations: a state of a forward obligation reaches the error,
+// so no backward frame excludes it, and vice versa.  But a state
+// that both reach, one in a forward obligation's cube and one that
+// a backward obligation has reached from an initial state, is a
+// counterexample, so each obligation is matched against the recent
+// ones of the other direction, and a match decides the check at
+// once.  Otherwise the first verdict of either check is the answer.
+namespace Reverse {
+
+  // Checks property propertyIndex of aig, which must be in the
+  // canonical AIGER order, backward, with a Model of the given SAT
+  // backend and CNF encoding (see Model.h).  The outcome's witness is
+  // a concrete counterexample; a proof yields no forward invariant,
+  // so invariant and lemmas are left empty.  Options::lemmas,
+  // frames, and obligations are ignored.
+  IC3::Result check(aiger * aig, unsigned int propertyIndex, 
+                    const string & backend, const string & encoding, 
+                    const IC3::Options & options, 
+                    IC3::Outcome * outcome = NULL);
+
+  // Checks in both directions at once.  Only the forward check
+  // reports statistics, trace events, and progress, and takes
+  // options.lemmas and options.frames; options.cancel is polled after
+  // each level of either.  Safe outcomes of the forward check keep
+  // their invariant.
+  IC3::Result bidirectional(aiger * aig, unsigned int propertyIndex, 
+                            const string & backend, const string & encoding, 
+                            const IC3::Options & options, 
+                            IC3::Outcome * outcome = NULL);
+
+}
+
+#endif
@@ -0,0 +1,316 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include "SatSolver.h"
+#include "Solver.h"
+
+// Access to Minisat's learned clauses, for sharing them.
+class SharingMinisat : public Minisat::Solver {
+public:
+  void collect(size_t maxSize, Minisat::Var maxVar, 
+               std::vector<SatSolver::Learnt> & out) {
+    for (int i = 0; i < learnts.size(); ++i) {
+      Minisat::Clause & c = ca[learnts[i]];
+      if ((size_t) c.size() > maxSize) continue;
+      int j = 0;
+      while (j < c.size() && var(c[j]) < maxVar) ++j;
+      if (j < c.size()) continue;
+      out.push_back(SatSolver::Learnt());
+      for (j = 0; j < c.size(); ++j) out.back().lits.push_back(c[j]);
+      out.back().activity = c.activity();
+    }
+  }
+
+protected:
+  // At decision level 0: adds ps as a learned clause with activity 0,
+  // so that the next reduction of the learned clauses deletes it
+  // unless it has taken part in a conflict.
+  bool learn(Minisat::vec<Minisat::Lit> & ps) {
+    if (!ok) return false;
+    int j = 0;
+    for (int i = 0; i < ps.size(); ++i) {
+      if (value(ps[i]) == Minisat::l_True) return true;
+      if (value(ps[i]) != Minisat::l_False) ps[j++] = ps[i];
+    }
+    ps.shrink(ps.size() - j);
+    if (ps.size() < 2) return addClause_(ps);
+    Minisat::CRef cr = ca.alloc(ps, true);
+    learnts.push(cr);
+    attachClause(cr);
+    return true;
+  }
+};
+
+// Minisat as is: each solve() starts from decision level 0.
+class PlainMinisat : public SharingMinisat {
+public:
+  bool add(Minisat::vec<Minisat::Lit> & cls) { return addClause_(cls); }
+  Minisat::lbool solveAssuming(const Minisat::vec<Minisat::Lit> & assumps) {
+    return solveLimited(assumps);
+  }
+  void release(Minisat::Lit l) { releaseVar(l); }
+  bool simplifyDB() { return simplify(); }
+  uint64_t reused() const { return 0; }
+  bool addLearnt(Minisat::vec<Minisat::Lit> & ps) { return learn(ps); }
+};
+
+// Minisat, but keeping the trail between solve() calls: consecutive
+// queries, e.g., from mic(), often share a long prefix of assumptions,
+// so the next solve() backtracks only to where the assumptions
+// diverge rather than to level 0, saving their propagation.  This
+// requires adding clauses above level 0 (see add()) and deferring
+// releaseVar(), which asserts a unit, and imported learned clauses
+// (see addLearnt()) until the solver is next at level 0.  Callers
+// should put a query's activation literal last, so that it does not
+// end the common prefix.
+class ReuseMinisat : public SharingMinisat {
+public:
+  ReuseMinisat() : nReused(0) {}
+
+  bool add(Minisat::vec<Minisat::Lit> & ps) {
+    if (decisionLevel() == 0) return addClause_(ps);
+    if (!ok) return false;
+    // normalize as addClause_() does, but with respect to level 0
+    std::sort(&ps[0], &ps[0] + ps.size());
+    Minisat::Lit p = Minisat::lit_Undef;
+    int i, j;
+    for (i = j = 0; i < ps.size(); ++i) {
+      bool fixed = value(ps[i]) != Minisat::l_Undef && level(var(ps[i])) == 0;
+      if ((fixed && value(ps[i]) == Minisat::l_True) || ps[i] == ~p)
+        return true;
+      else if (!(fixed && value(ps[i]) == Minisat::l_False) && ps[i] != p)
+        ps[j++] = p = ps[i];
+    }
+    ps.shrink(i - j);
+    if (ps.size() < 2) {
+      cancelUntil(0);
+      return addClause_(ps);
+    }
+    // watch the two best literals: non-false before false, and false
+    // ones by decreasing level
+    for (int k = 0; k < 2; ++k)
+      for (int l = k+1; l < ps.size(); ++l)
+        if (better(ps[l], ps[k])) std::swap(ps[l], ps[k]);
+    Minisat::lbool v0 = value(ps[0]), v1 = value(ps[1]);
+    if (v0 == Minisat::l_False) {
+      // conflicting: not worth the trouble
+      cancelUntil(0);
+      return addClause_(ps);
+    }
+    if (v1 == Minisat::l_False 
+        && (v0 == Minisat::l_Undef || level(var(ps[0])) > level(var(ps[1])))) {
+      // unit (or implied too late): backtrack to where it became unit
+      // and propagate it there
+      cancelUntil(level(var(ps[1])));
+      Minisat::CRef cr = ca.alloc(ps, false);
+      clauses.push(cr);
+      attachClause(cr);
+      uncheckedEnqueue(ps[0], cr);
+      return true;
+    }
+    Minisat::CRef cr = ca.alloc(ps, false);
+    clauses.push(cr);
+    attachClause(cr);
+    return true;
+  }
+
+  Minisat::lbool solveAssuming(const Minisat::vec<Minisat::Lit> & assumps) {
+    // keep the levels of the longest common prefix of assumptions
+    int keep = 0;
+    while (keep < assumps.size() && keep < assumptions.size() 
+           && assumps[keep] == assumptions[keep])
+      ++keep;
+    // time to flush releases or imports
+    if (released.size() > 64 || pending.size() > 64) keep = 0;
+    if (keep < decisionLevel()) cancelUntil(keep);
+    if (decisionLevel() == 0) {
+      flushReleased();
+      flushPending();
+    }
+    else nReused += trail.size() - trail_lim[0];
+    assumps.copyTo(assumptions);
+    return solveKeeping();
+  }
+
+  void release(Minisat::Lit l) {
+    if (decisionLevel() == 0) {
+      releaseVar(l);
+      return;
+    }
+    // don't let it be a decision in the meantime
+    setDecisionVar(var(l), false);
+    released.push(l);
+  }
+
+  bool simplifyDB() {
+    cancelUntil(0);
+    flushReleased();
+    flushPending();
+    return simplify();
+  }
+
+  uint64_t reused() const { return nReused; }
+
+  // Backtracking to level 0 here would throw away the kept prefix on
+  // each import, so the clause waits for the next query that
+  // backtracks there anyway.
+  bool addLearnt(Minisat::vec<Minisat::Lit> & ps) {
+    if (decisionLevel() == 0) return learn(ps);
+    pending.push_back(std::vector<Minisat::Lit>());
+    for (int i = 0; i < ps.size(); ++i) pending.back().push_back(ps[i]);
+    return ok;
+  }
+
+private:
+  Minisat::vec<Minisat::Lit> released;  // deferred releaseVar()s
+  std::vector< std::vector<Minisat::Lit> > pending;  // deferred imports
+  uint64_t nReused;                      // assignments kept
+
+  // Whether l is a better watch than m.
+  bool better(Minisat::Lit l, Minisat::Lit m) const {
+    bool lf = value(l) == Minisat::l_False, mf = value(m) == Minisat::l_False;
+    if (lf != mf) return mf;
+    return lf && level(var(l)) > level(var(m));
+  }
+
+  void flushReleased() {
+    for (int i = 0; i < released.size(); ++i) {
+      setDecisionVar(var(released[i]), true);
+      releaseVar(released[i]);
+    }
+    released.clear();
+  }
+
+  void flushPending() {
+    Minisat::vec<Minisat::Lit> ps;
+    for (size_t i = 0; i < pending.size(); ++i) {
+      ps.clear();
+      for (size_t j = 0; j < pending[i].size(); ++j) ps.push(pending[i][j]);
+      learn(ps);
+    }
+    pending.clear();
+  }
+
+  static double luby(double y, int x) {
+    int size, seq;
+    for (size = 1, seq = 0; size < x+1; seq++, size = 2*size+1);
+    while (size-1 != x) {
+      size = (size-1)>>1;
+      seq--;
+      x = x % size;
+    }
+    return pow(y, seq);
+  }
+
+  // Solver::solve_() without the final backtrack to level 0.
+  Minisat::lbool solveKeeping() {
+    model.clear();
+    conflict.clear();
+    if (!ok) return Minisat::l_False;
+    solves++;
+    max_learnts = nClauses() * learntsize_factor;
+    if (max_learnts < min_learnts_lim) max_learnts = min_learnts_lim;
+    learntsize_adjust_confl = learntsize_adjust_start_confl;
+    learntsize_adjust_cnt = (int) learntsize_adjust_confl;
+    Minisat::lbool status = Minisat::l_Undef;
+    int curr_restarts = 0;
+    while (status == Minisat::l_Undef) {
+      double rest_base = luby_restart 
+        ? luby(restart_inc, curr_restarts) : pow(restart_inc, curr_restarts);
+      status = search((int) (rest_base * restart_first));
+      if (!withinBudget()) break;
+      curr_restarts++;
+    }
+    if (status == Minisat::l_True) {
+      model.growTo(nVars());
+      for (int i = 0; i < nVars(); i++) model[i] = value(i);
+    }
+    else if (status == Minisat::l_False && conflict.size() == 0)
+      ok = false;
+    if (status == Minisat::l_True)
+      cancelUntil(std::min(decisionLevel(), assumptions.size()));
+    else if (!ok)
+      cancelUntil(0);
+    return status;
+  }
+};
+
+// Adapts one of the above to SatSolver.
+template<class S>
+class MinisatAdapter : public SatSolver {
+public:
+  Minisat::Var newVar() { return slv.newVar(); }
+  int nVars() const { return slv.nVars(); }
+  bool addClause(const Minisat::vec<Minisat::Lit> & cls) {
+    Minisat::vec<Minisat::Lit> cp;
+    cls.copyTo(cp);
+    return slv.add(cp);
+  }
+  Minisat::lbool solve(const Minisat::vec<Minisat::Lit> & assumps) {
+    return slv.solveAssuming(assumps);
+  }
+  Minisat::lbool modelValue(Minisat::Var v) const { 
+    return slv.modelValue(v); 
+  }
+  bool failed(Minisat::Lit a) const { return slv.conflict.has(~a); }
+  void releaseVar(Minisat::Lit l) { slv.release(l); }
+  bool simplify() { return slv.simplifyDB(); }
+  uint64_t conflicts() const { return slv.conflicts; }
+  uint64_t propagations() const { return slv.propagations; }
+  uint64_t reusedAssignments() const { return slv.reused(); }
+  void setConfBudget(int64_t n) {
+    if (n < 0) slv.budgetOff();
+    else slv.setConfBudget(n);
+  }
+  void interrupt() { slv.interrupt(); }
+  void randomize(double seed) {
+    slv.random_seed = seed;
+    slv.rnd_init_act = true;
+  }
+  void learnts(size_t maxSize, Minisat::Var maxVar, 
+               std::vector<Learnt> & out) {
+    slv.collect(maxSize, maxVar, out);
+  }
+  bool addLearnt(const Minisat::vec<Minisat::Lit> & cls) {
+    Minisat::vec<Minisat::Lit> cp;
+    cls.copyTo(cp);
+    return slv.addLearnt(cp);
+  }
+
+private:
+  S slv;
+};
+
+SatSolver * newSatSolver(const std::string & backend) {
+  if (backend == "minisat") return new MinisatAdapter<PlainMinisat>();
+  if (backend == "minisat-reuse") return new MinisatAdapter<ReuseMinisat>();
+  // add further backends here
+  return NULL;
+}
+
+const char * satBackends() {
+  return "minisat minisat-reuse";
+}
@@ -0,0 +1,133 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef SatSolver_h_INCLUDED
+#define SatSolver_h_INCLUDED
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "SolverTypes.h"
+#include "Vec.h"
+
+// The interface of the incremental SAT solvers used by Model and IC3,
+// which is just what IC3 needs: solving under assumptions, models,
+// final conflicts over assumptions, and releasing activation
+// variables.  Literals, variables, and truth values are Minisat's
+// types throughout, so that a backend only needs to translate them if
+// its own differ.  Minisat is the default backend; see newSatSolver()
+// to add others.
+class SatSolver {
+public:
+  virtual ~SatSolver() {}
+
+  virtual Minisat::Var newVar() = 0;
+  virtual int nVars() const = 0;
+
+  virtual bool addClause(const Minisat::vec<Minisat::Lit> & cls) = 0;
+  bool addClause(Minisat::Lit a) {
+    Minisat::vec<Minisat::Lit> cls;
+    cls.push(a);
+    return addClause(cls);
+  }
+  bool addClause(Minisat::Lit a, Minisat::Lit b) {
+    Minisat::vec<Minisat::Lit> cls;
+    cls.push(a); cls.push(b);
+    return addClause(cls);
+  }
+  bool addClause(Minisat::Lit a, Minisat::Lit b, Minisat::Lit c) {
+    Minisat::vec<Minisat::Lit> cls;
+    cls.push(a); cls.push(b); cls.push(c);
+    return addClause(cls);
+  }
+
+  // Solves under the assumptions, within the conflict budget; returns
+  // l_Undef if the budget runs out or the solver is interrupted.
+  virtual Minisat::lbool solve(const Minisat::vec<Minisat::Lit> & assumps) = 0;
+  Minisat::lbool solve(Minisat::Lit a) {
+    Minisat::vec<Minisat::Lit> assumps;
+    assumps.push(a);
+    return solve(assumps);
+  }
+  Minisat::lbool solve() {
+    Minisat::vec<Minisat::Lit> assumps;
+    return solve(assumps);
+  }
+
+  // After a satisfiable solve(): the value of v.
+  virtual Minisat::lbool modelValue(Minisat::Var v) const = 0;
+  // After an unsatisfiable solve(): whether assumption a is part of
+  // the final conflict.
+  virtual bool failed(Minisat::Lit a) const = 0;
+
+  // Asserts l permanently and allows the solver to reuse var(l),
+  // e.g., to retire an activation literal.
+  virtual void releaseVar(Minisat::Lit l) = 0;
+  // Simplifies the clause database at decision level 0.
+  virtual bool simplify() = 0;
+
+  // Conflicts and propagations so far.
+  virtual uint64_t conflicts() const = 0;
+  virtual uint64_t propagations() const = 0;
+  // Assignments kept from earlier queries rather than propagated
+  // again, for backends that reuse the trail.
+  virtual uint64_t reusedAssignments() const { return 0; }
+  // Limits the next solve() calls to n further conflicts; n < 0 for
+  // no limit.
+  virtual void setConfBudget(int64_t n) = 0;
+  // Makes the running solve() return l_Undef; may be called from
+  // another thread.
+  virtual void interrupt() = 0;
+  // Randomizes decisions, for random runs.
+  virtual void randomize(double seed) = 0;
+
+  // For sharing learned clauses between solvers over the same
+  // variables.  A learned clause, with its activity, which stays 0
+  // for a clause from addLearnt() until it takes part in a conflict.
+  struct Learnt {
+    std::vector<Minisat::Lit> lits;
+    double activity;
+  };
+  // Appends the learned clauses of at most maxSize literals over
+  // variables below maxVar to out; backends that do not expose their
+  // learned clauses append none.
+  virtual void learnts(size_t maxSize, Minisat::Var maxVar, 
+                       std::vector<Learnt> & out) {
+    (void) maxSize; (void) maxVar; (void) out;
+  }
+  // Adds a clause implied by the solver's clauses as if learned, so
+  // that the solver may delete it again if it goes unused.
+  virtual bool addLearnt(const Minisat::vec<Minisat::Lit> & cls) {
+    return addClause(cls);
+  }
+};
+
+// Creates a solver of the named backend, or NULL if there is no such
+// backend.
+SatSolver * newSatSolver(const std::string & backend = "minisat");
+
+// Names of the available backends, separated by spaces.
+const char * satBackends();
+
+#endif
@@ -0,0 +1,472 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <utility>
+#include <thread>
+#include <unistd.h>
+
+extern "C" {
+#include "aiger.h"
+}
+#include "Service.h"
+#include "Stats.h"
+
+namespace Service {
+
+  bool parseJob(const string & line, Job & job, string & err) {
+    istringstream ss(line);
+    string tok;
+    if (!(ss >> job.path)) {
+      err = "empty job";
+      return false;
+    }
+    while (ss >> tok) {
+      if (tok == "-b")
+        job.basic = true;
+      else if (tok == "-a")
+        job.adaptive = true;
+      else if (tok == "-share")
+        job.share = true;
+      else if (tok == "-t")
+        job.ternary = true;
+      else if (tok == "-j")
+        job.json = true;
+      else if (tok == "-T" && ss >> tok)
+        job.limits.seconds = atof(tok.c_str());
+      else if (tok == "-C" && ss >> tok)
+        job.limits.conflicts = strtoull(tok.c_str(), NULL, 10);
+      else if (tok == "-sat" && ss >> tok) {
+        SatSolver * slv = newSatSolver(tok);
+        if (!slv) {
+          err = "unknown SAT backend " + tok;
+          return false;
+        }
+        delete slv;
+        job.backend = tok;
+      }
+      else if (tok == "-cnf" && ss >> tok) {
+        if (tok != "tseitin" && tok != "compact") {
+          err = "unknown encoding " + tok;
+          return false;
+        }
+        job.encoding = tok;
+      }
+      else if (!tok.empty() && tok.find_first_not_of("0123456789") 
+               == string::npos)
+        job.property = (unsigned) atoi(tok.c_str());
+      else {
+        err = "bad option " + tok;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  ModelCache::~ModelCache() {
+    for (map<Key, Entry>::iterator i = entries.begin(); 
+         i != entries.end(); ++i)
+      for (size_t j = 0; j < i->second.idle.size(); ++j)
+        delete i->second.idle[j];
+  }
+
+  Model * ModelCache::acquire(const Job & job, string & err) {
+    struct stat st;
+    if (stat(job.path.c_str(), &st)) {
+      err = "cannot stat " + job.path;
+      return NULL;
+    }
+    Key key;
+    key.path = job.path;
+    key.mtime = (long) st.st_mtime;
+    key.property = job.property;
+    key.encoding = job.encoding;
+    {
+      lock_guard<mutex> lock(mtx);
+      map<Key, Entry>::iterator i = entries.find(key);
+      if (i != entries.end() && !i->second.idle.empty()) {
+        ++hits;
+        Model * model = i->second.idle.back();
+        i->second.idle.pop_back();
+        recency.splice(recency.begin(), recency, i->second.lru);
+        inUse.insert(make_pair(model, key));
+        return model;
+      }
+      ++misses;
+    }
+    // load outside of the lock, as it can take a while
+    aiger * aig = aiger_init();
+    const char * msg = aiger_open_and_read_from_file(aig, job.path.c_str());
+    if (msg) {
+      err = msg;
+      aiger_reset(aig);
+      return NULL;
+    }
+    Model * model = modelFromAiger(aig, job.property);
+    aiger_reset(aig);
+    if (!model) {
+      err = "bad property index";
+      return NULL;
+    }
+    model->setEncoding(job.encoding);
+    lock_guard<mutex> lock(mtx);
+    inUse.insert(make_pair(model, key));
+    return model;
+  }
+
+  void ModelCache::release(Model * model) {
+    lock_guard<mutex> lock(mtx);
+    map<Model *, Key>::iterator u = inUse.find(model);
+    assert (u != inUse.end());
+    Key key = u->second;
+    inUse.erase(u);
+    map<Key, Entry>::iterator i = entries.find(key);
+    if (i == entries.end()) {
+      i = entries.insert(make_pair(key, Entry())).first;
+      recency.push_front(key);
+      i->second.lru = recency.begin();
+    }
+    else
+      recency.splice(recency.begin(), recency, i->second.lru);
+    i->second.idle.push_back(model);
+    evict();
+  }
+
+  // Drops least recently used keys beyond capacity, with their idle
+  // models.  A model in use is kept: release() re-enters its key as
+  // the most recently used, evicting others if need be.
+  void ModelCache::evict() {
+    while (entries.size() > capacity) {
+      map<Key, Entry>::iterator i = entries.find(recency.back());
+      for (size_t j = 0; j < i->second.idle.size(); ++j)
+        delete i->second.idle[j];
+      entries.erase(i);
+      recency.pop_back();
+    }
+  }
+
+  void ModelCache::stats(size_t & _hits, size_t & _misses, size_t & models) {
+    lock_guard<mutex> lock(mtx);
+    _hits = hits;
+    _misses = misses;
+    models = inUse.size();
+    for (map<Key, Entry>::const_iterator i = entries.begin(); 
+         i != entries.end(); ++i)
+      models += i->second.idle.size();
+  }
+
+  string runJob(const Job & job, ModelCache & cache) {
+    string err;
+    uint64_t start = nanotime();
+    Model * model = cache.acquire(job, err);
+    if (!model) return "error " + err;
+    model->setSatBackend(job.backend);
+    stringstream json;
+    IC3::Options opts = job.options();
+    opts.json = job.json ? &json : NULL;
+    // with an outcome, running out of budget is reported here rather
+    // than on stdout, which the daemon and other jobs share
+    IC3::Outcome out;
+    IC3::Result rv = IC3::check(*model, opts, &out);
+    cache.release(model);
+    stringstream ss;
+    ss << rv << " " << (nanotime() - start) / 1e9;
+    if (rv == IC3::Unknown) ss << " " << out.stopped << " " << out.k;
+    if (job.json) {
+      string js = json.str();
+      while (!js.empty() && js[js.size()-1] == '\n') js.erase(js.size()-1);
+      ss << " " << js;
+    }
+    return ss.str();
+  }
+
+  static bool sendLine(int fd, const string & line) {
+    string buf = line + "\n";
+    size_t off = 0;
+    while (off < buf.size()) {
+      ssize_t n = send(fd, buf.data() + off, buf.size() - off, MSG_NOSIGNAL);
+      if (n <= 0) return false;
+      off += (size_t) n;
+    }
+    return true;
+  }
+
+  // Answers each line of a connection in turn until it closes.
+  static void serveConnection(int fd, ModelCache & cache, size_t & jobs,
+                              mutex & jobsMutex) {
+    string buf;
+    char chunk[4096];
+    while (true) {
+      size_t nl;
+      while ((nl = buf.find('\n')) == string::npos) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n <= 0) return;
+        buf.append(chunk, (size_t) n);
+      }
+      string line = buf.substr(0, nl);
+      buf.erase(0, nl+1);
+      if (!line.empty() && line[line.size()-1] == '\r') 
+        line.erase(line.size()-1);
+      string rsp;
+      if (line == "stats") {
+        size_t hits, misses, models;
+        cache.stats(hits, misses, models);
+        stringstream ss;
+        {
+          lock_guard<mutex> lock(jobsMutex);
+          ss << "jobs " << jobs;
+        }
+        ss << " hits " << hits << " misses " << misses 
+           << " models " << models;
+        rsp = ss.str();
+      }
+      else {
+        Job job;
+        string err;
+        if (parseJob(line, job, err)) {
+          rsp = runJob(job, cache);
+          lock_guard<mutex> lock(jobsMutex);
+          ++jobs;
+        }
+        else
+          rsp = "error " + err;
+      }
+      if (!sendLine(fd, rsp)) return;
+    }
+  }
+
+  int serve(const string & path, size_t workers, size_t cacheSize) {
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+      cout << "cannot create socket" << endl;
+      return 1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      cout << "socket path too long" << endl;
+      return 1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) 
+        || listen(sock, 64)) {
+      cout << "cannot listen on " << path << endl;
+      close(sock);
+      return 1;
+    }
+
+    ModelCache cache(cacheSize);
+    size_t jobs = 0;
+    mutex jobsMutex;
+    deque<int> pending;  // accepted connections
+    mutex pendingMutex;
+    condition_variable pendingCV;
+    vector<thread> pool;
+    for (size_t i = 0; i < max(workers, (size_t) 1); ++i)
+      pool.push_back(thread([&]() {
+        while (true) {
+          int fd;
+          {
+            unique_lock<mutex> lock(pendingMutex);
+            pendingCV.wait(lock, [&]() { return !pending.empty(); });
+            fd = pending.front();
+            pending.pop_front();
+          }
+          if (fd < 0) return;
+          serveConnection(fd, cache, jobs, jobsMutex);
+          close(fd);
+        }
+      }));
+
+    int rv = 0;
+    while (true) {
+      int fd = accept(sock, NULL, NULL);
+      if (fd < 0) {
+        if (errno == EINTR) continue;
+        cout << "accept failed" << endl;
+        rv = 1;
+        break;
+      }
+      lock_guard<mutex> lock(pendingMutex);
+      pending.push_back(fd);
+      pendingCV.notify_one();
+    }
+    // stop the workers once they finish their connections
+    {
+      lock_guard<mutex> lock(pendingMutex);
+      for (size_t i = 0; i < pool.size(); ++i) pending.push_back(-1);
+      pendingCV.notify_all();
+    }
+    for (size_t i = 0; i < pool.size(); ++i) pool[i].join();
+    close(sock);
+    unlink(path.c_str());
+    return rv;
+  }
+
+  int batch(const string & manifest, const Job & defaults, size_t workers,
+            size_t cacheSize) {
+    ifstream in(manifest.c_str());
+    if (!in) {
+      cout << "cannot open " << manifest << endl;
+      return 1;
+    }
+    string dir;
+    size_t slash = manifest.rfind('/');
+    if (slash != string::npos) dir = manifest.substr(0, slash+1);
+    // (file size, job), to be sorted largest first
+    vector<pair<off_t, Job> > jobs;
+    string line;
+    size_t lineno = 0;
+    while (getline(in, line)) {
+      ++lineno;
+      size_t b = line.find_first_not_of(" \t\r");
+      if (b == string::npos || line[b] == '#') continue;
+      Job job(defaults);
+      string err;
+      if (!parseJob(line, job, err)) {
+        cout << manifest << ":" << lineno << ": " << err << endl;
+        return 1;
+      }
+      if (!job.path.empty() && job.path[0] != '/') job.path = dir + job.path;
+      struct stat st;
+      jobs.push_back(make_pair(stat(job.path.c_str(), &st) ? 0 : st.st_size, 
+                               job));
+    }
+    stable_sort(jobs.begin(), jobs.end(), 
+                [](const pair<off_t, Job> & a, const pair<off_t, Job> & b) {
+                  return a.first > b.first;
+                });
+
+    ModelCache cache(cacheSize);
+    size_t next = 0, failed = 0;
+    mutex mtx;  // guards next, failed, and cout
+    vector<thread> pool;
+    for (size_t i = 0; i < max(workers, (size_t) 1); ++i)
+      pool.push_back(thread([&]() {
+        while (true) {
+          size_t j;
+          {
+            lock_guard<mutex> lock(mtx);
+            if (next == jobs.size()) return;
+            j = next++;
+          }
+          // runJob() keeps the check itself off stdout, so that this
+          // line is the job's only output
+          const Job & job = jobs[j].second;
+          string rsp = runJob(job, cache);
+          lock_guard<mutex> lock(mtx);
+          if (rsp.compare(0, 5, "error") == 0) ++failed;
+          cout << job.path << " " << job.property << " " << rsp << endl;
+        }
+      }));
+    for (size_t i = 0; i < pool.size(); ++i) pool[i].join();
+    return failed ? 1 : 0;
+  }
+
+  int seeds(aiger * aig, const Job & job, unsigned int seed, size_t runs,
+            size_t workers) {
+    // a Model serves one check at a time, so one per worker
+    vector<Model *> models;
+    for (size_t i = 0; i < max(min(workers, runs), (size_t) 1); ++i) {
+      Model * model = modelFromAiger(aig, job.property);
+      if (!model) break;
+      model->setSatBackend(job.backend);
+      model->setEncoding(job.encoding);
+      models.push_back(model);
+    }
+    if (models.empty()) return 1;
+
+    vector<IC3::Result> results(runs);
+    vector<IC3::Outcome> outcomes(runs);
+    size_t next = 0;
+    mutex mtx;  // guards next and cout
+    vector<thread> pool;
+    for (size_t w = 0; w < models.size(); ++w)
+      pool.push_back(thread([&, w]() {
+        while (true) {
+          size_t i;
+          {
+            lock_guard<mutex> lock(mtx);
+            if (next == runs) return;
+            i = next++;
+          }
+          IC3::Options opts = job.options();
+          opts.random = true;
+          opts.seed = seed + i;
+          results[i] = IC3::check(*models[w], opts, &outcomes[i]);
+          lock_guard<mutex> lock(mtx);
+          cout << "seed " << seed + i << ": " << results[i] << " " 
+               << outcomes[i].seconds << "s K=" << outcomes[i].k 
+               << " queries=" << outcomes[i].queries << endl;
+        }
+      }));
+    for (size_t i = 0; i < pool.size(); ++i) pool[i].join();
+    for (size_t i = 0; i < models.size(); ++i) delete models[i];
+
+    vector<double> secs, queries, ks;
+    size_t count[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < runs; ++i) {
+      secs.push_back(outcomes[i].seconds);
+      queries.push_back(outcomes[i].queries);
+      ks.push_back(outcomes[i].k);
+      ++count[results[i]];
+    }
+    cout << runs << " runs: " << count[IC3::Safe] << " safe, " 
+         << count[IC3::Unsafe] << " unsafe, " << count[IC3::Unknown] 
+         << " unknown" << endl;
+    const char * names[] = { "time", "queries", "K" };
+    vector<double> * samples[] = { &secs, &queries, &ks };
+    cout << setw(8) << "" << setw(12) << "median" << setw(12) << "q1" 
+         << setw(12) << "q3" << setw(12) << "mean" << setw(12) << "variance" 
+         << endl;
+    for (size_t i = 0; i < 3; ++i) {
+      Spread sp(*samples[i]);
+      cout << setw(8) << left << names[i] << right
+           << setw(12) << sp.median << setw(12) << sp.q1 << setw(12) << sp.q3 
+           << setw(12) << sp.mean << setw(12) << sp.variance << endl;
+    }
+    if (count[IC3::Safe] && count[IC3::Unsafe]) {
+      cout << "runs disagree" << endl;
+      return 1;
+    }
+    cout << (count[IC3::Safe] ? IC3::Safe 
+             : count[IC3::Unsafe] ? IC3::Unsafe : IC3::Unknown) << endl;
+    return 0;
+  }
+
+}
@@ -0,0 +1,145 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef Service_h_INCLUDED
+#define Service_h_INCLUDED
+
+#include <list>
+#include <map>
+#include <mutex>
+
+#include "IC3.h"
+#include "Model.h"
+
+namespace Service {
+
+  // A check requested of the daemon, given as one line:
+  //
+  //   <AIGER file> [<property ID>] [-b] [-a] [-share] [-t] [-T <sec>] 
+  //                [-C <conflicts>] [-sat <backend>] [-cnf <encoding>] 
+  //                [-j]
+  //
+  // with the options as for the command line; -j asks for JSON
+  // statistics in the response.
+  struct Job {
+    Job() : property(0), basic(false), adaptive(false), share(false), 
+            ternary(false), json(false), backend("minisat"), 
+            encoding("tseitin") {}
+    string path;
+    unsigned int property;
+    bool basic, adaptive, share, ternary, json;
+    string backend, encoding;
+    IC3::Limits limits;
+
+    // The check's options, other than output
+    IC3::Options options() const {
+      IC3::Options opts;
+      opts.basic = basic;
+      opts.adaptive = adaptive;
+      opts.share = share;
+      opts.ternary = ternary;
+      opts.limits = limits;
+      return opts;
+    }
+  };
+
+  // Parses a job into job, whose fields are taken as defaults;
+  // returns false and sets err if it is malformed.
+  bool parseJob(const string & line, Job & job, string & err);
+
+  // A cache of parsed Models, keyed by file, modification time,
+  // property, and CNF encoding, and bounded by the number of keys in LRU order.  A
+  // Model keeps its simplified TR (see Model::loadTransitionRelation),
+  // so later checks skip both parsing and simplification.  A Model
+  // serves one check at a time, so a key holds a pool of idle Models.
+  class ModelCache {
+  public:
+    ModelCache(size_t _capacity) : capacity(_capacity), hits(0), misses(0) {}
+    ~ModelCache();
+
+    // Returns an idle Model for the job, loading one if necessary, or
+    // NULL with err set.
+    Model * acquire(const Job & job, string & err);
+    // Returns a Model obtained from acquire() to the pool.
+    void release(Model * model);
+
+    void stats(size_t & _hits, size_t & _misses, size_t & models);
+
+  private:
+    struct Key {
+      string path;
+      long mtime;
+      unsigned int property;
+      string encoding;
+      bool operator<(const Key & k) const {
+        if (path != k.path) return path < k.path;
+        if (mtime != k.mtime) return mtime < k.mtime;
+        if (property != k.property) return property < k.property;
+        return encoding < k.encoding;
+      }
+    };
+    struct Entry {
+      vector<Model *> idle;
+      list<Key>::iterator lru;  // position in recency list
+    };
+    void evict();
+
+    size_t capacity;
+    map<Key, Entry> entries;
+    list<Key> recency;          // most recently used first
+    map<Model *, Key> inUse;
+    size_t hits, misses;
+    mutex mtx;
+  };
+
+  // Runs a job on a Model from cache; returns the response line
+  // "<result> <seconds>[ <JSON statistics>]" or "error <message>".
+  string runJob(const Job & job, ModelCache & cache);
+
+  // Serves jobs over a Unix domain socket at path, one job per line
+  // and one response line per job, on a pool of worker threads; a
+  // connection is served by one worker.  The line "stats" reports the
+  // number of jobs and cache hits and misses.  Returns only on error.
+  int serve(const string & path, size_t workers, size_t cacheSize);
+
+  // Checks the jobs of a manifest, in the job format above (blank
+  // lines and lines starting with # are skipped), on a pool of worker
+  // threads, largest files first.  Options in defaults apply unless
+  // a job overrides them; relative paths are relative to the
+  // manifest.  Prints "<file> <property ID> <response>" per job as
+  // soon as it finishes.  Returns nonzero if any job failed.
+  int batch(const string & manifest, const Job & defaults, size_t workers,
+            size_t cacheSize);
+
+  // Checks the property of aig runs times with randomization, on a
+  // pool of worker threads, where run i uses seed + i so that any run
+  // can be repeated with -r -seed.  Prints each run as it finishes,
+  // then the median, quartiles, mean, and variance of time, queries,
+  // and K, and finally the common result.  Returns nonzero if the
+  // runs disagree on safety.
+  int seeds(aiger * aig, const Job & job, unsigned int seed, size_t runs,
+            size_t workers);
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef STATS_H_INCLUDED
+#define STATS_H_INCLUDED
+
+#include <algorithm>
+#include <ostream>
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+// Small tools for profiling: a monotonic nanosecond clock and latency
+// histograms that can be written as JSON.
+
+// Monotonic time in nanoseconds.
+inline uint64_t nanotime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+// A latency histogram with power-of-two buckets: bucket b counts the
+// samples in [2^b, 2^(b+1)) ns.
+class Histogram {
+public:
+  Histogram() : buckets(64, 0), n(0), total(0) {}
+
+  void add(uint64_t ns) {
+    size_t b = 0;
+    while (ns >> (b+1)) ++b;
+    ++buckets[b];
+    ++n;
+    total += ns;
+  }
+  uint64_t count() const { return n; }
+  uint64_t sum() const { return total; }
+
+  // Upper bound (in ns) of the bucket holding the q-quantile.
+  uint64_t quantile(double q) const {
+    uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+      seen += buckets[b];
+      if (seen > 0 && seen >= q * n) return 2ull << b;
+    }
+    return 0;
+  }
+
+  // {"count": n, "ns": total, "p50": ..., "p90": ..., "p99": ...,
+  //  "buckets": [[lower bound in ns, count], ...]}
+  void json(std::ostream & os) const {
+    os << "{\"count\":" << n << ",\"ns\":" << total
+       << ",\"p50\":" << quantile(0.5) << ",\"p90\":" << quantile(0.9)
+       << ",\"p99\":" << quantile(0.99) << ",\"buckets\":[";
+    bool first = true;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+      if (!buckets[b]) continue;
+      if (!first) os << ",";
+      first = false;
+      os << "[" << (b ? 1ull << b : 0) << "," << buckets[b] << "]";
+    }
+    os << "]}";
+  }
+
+private:
+  std::vector<uint64_t> buckets;
+  uint64_t n, total;
+};
+
+// Exact q-quantile of a set of samples, which it sorts.
+inline uint64_t percentile(std::vector<uint64_t> & ns, double q) {
+  if (ns.empty()) return 0;
+  std::sort(ns.begin(), ns.end());
+  size_t i = (size_t) (q * (ns.size() - 1) + 0.5);
+  return ns[i];
+}
+
+// Mean, variance, and quartiles (interpolated) of a sample.
+struct Spread {
+  Spread(std::vector<double> xs) : mean(0), variance(0), q1(0), median(0),
+                                   q3(0) {
+    if (xs.empty()) return;
+    std::sort(xs.begin(), xs.end());
+    for (size_t i = 0; i < xs.size(); ++i) mean += xs[i];
+    mean /= xs.size();
+    for (size_t i = 0; i < xs.size(); ++i)
+      variance += (xs[i] - mean) * (xs[i] - mean);
+    if (xs.size() > 1) variance /= xs.size() - 1;
+    q1 = quantile(xs, 0.25);
+    median = quantile(xs, 0.5);
+    q3 = quantile(xs, 0.75);
+  }
+  double mean, variance, q1, median, q3;
+
+private:
+  static double quantile(const std::vector<double> & xs, double q) {
+    double pos = q * (xs.size() - 1);
+    size_t i = (size_t) pos;
+    if (i + 1 >= xs.size()) return xs.back();
+    return xs[i] + (pos - i) * (xs[i+1] - xs[i]);
+  }
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "Trace.h"
+
+namespace Trace {
+
+  static const char * names[NEvents][3] = {
+    { "level", "", "" },
+    { "obligation", "state", "depth" },
+    { "cti", "state", "depth" },
+    { "ctg", "size", "inductive" },
+    { "mic_drop", "position", "size" },
+    { "lemma", "size", "to_all" },
+    { "push", "size", "pushed" },
+    { "sat", "ns", "sat" }
+  };
+
+  const char * eventName(int event) {
+    return event >= 0 && event < NEvents ? names[event][0] : "unknown";
+  }
+
+  const char * fieldName(int event, int field) {
+    return event >= 0 && event < NEvents ? names[event][1 + field] : "";
+  }
+
+  Writer::Writer(size_t capacity) : 
+    head(0), tail(0), done(false), nStalls(0), file(NULL)
+  {
+    size_t n = 1;
+    while (n < capacity) n <<= 1;
+    ring.resize(n);
+    mask = n - 1;
+  }
+
+  bool Writer::open(const std::string & path) {
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    Header h;
+    memcpy(h.magic, "IC3T", 4);
+    h.version = 1;
+    h.recordSize = sizeof(Record);
+    h.reserved = 0;
+    fwrite(&h, sizeof(h), 1, file);
+    thr = std::thread(&Writer::flusher, this);
+    return true;
+  }
+
+  void Writer::close() {
+    if (!file) return;
+    done = true;
+    thr.join();
+    fclose(file);
+    file = NULL;
+  }
+
+  void Writer::flusher() {
+    while (true) {
+      uint64_t t = tail.load(std::memory_order_relaxed);
+      uint64_t h = head.load(std::memory_order_acquire);
+      if (h == t) {
+        // done is set after the last record, so check again once
+        if (done && head.load(std::memory_order_acquire) == t) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      // write out [t, h), which may wrap around
+      while (t < h) {
+        size_t i = t & mask, n = std::min((size_t) (h - t), ring.size() - i);
+        fwrite(&ring[i], sizeof(Record), n, file);
+        t += n;
+      }
+      tail.store(t, std::memory_order_release);
+    }
+    fflush(file);
+  }
+
+}
@@ -0,0 +1,123 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+#ifndef Trace_h_INCLUDED
+#define Trace_h_INCLUDED
+
+#include <atomic>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A compact binary trace of engine events (-trace), for offline
+// analysis with tools/tracedump.  The engine appends fixed-size
+// records to a ring buffer that a background thread drains to the
+// file, so recording an event costs a clock read and a few stores.
+// Each IC3 instance, which runs on one thread, has its own Writer,
+// so the ring has a single producer and a single consumer.  When the
+// ring is full, the engine waits for the flusher rather than lose
+// events; such stalls are counted.
+//
+// File format: a Header, then Records, in host byte order.
+
+namespace Trace {
+
+  enum Event {
+    Level,       // level: new frontier K
+    Obligation,  // level; a: state; b: depth
+    CTI,         // level; a: state; b: depth
+    CTG,         // level; a: CTG cube size; b: 1 if inductive (else joined)
+    MicDrop,     // level; a: position of dropped literal; b: new size
+    Lemma,       // level; a: size; b: 1 if added to all lower frames
+    Push,        // level: from; a: size; b: 1 if pushed
+    SatCall,     // level: query type; a: ns (saturated); b: 1 if SAT
+    NEvents
+  };
+
+  // Name of each event and of its a and b fields.
+  const char * eventName(int event);
+  const char * fieldName(int event, int field);
+
+  struct Header {
+    char magic[4];        // "IC3T"
+    uint32_t version;     // 1
+    uint32_t recordSize;  // sizeof(Record)
+    uint32_t reserved;
+  };
+
+  struct Record {
+    uint64_t ns;      // since the start of the run
+    uint32_t level;
+    uint32_t a, b;
+    uint8_t event;
+    uint8_t pad[3];
+  };
+
+  class Writer {
+  public:
+    // capacity: ring size in records, rounded up to a power of two.
+    Writer(size_t capacity = 1 << 16);
+    ~Writer() { close(); }
+
+    // Opens path and starts the flusher; returns false on failure.
+    bool open(const std::string & path);
+    // Drains the ring and closes the file.
+    void close();
+
+    void record(Event event, uint32_t level, uint64_t ns, uint32_t a = 0, 
+                uint32_t b = 0) {
+      uint64_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == ring.size()) {
+        ++nStalls;
+        while (h - tail.load(std::memory_order_acquire) == ring.size())
+          std::this_thread::yield();
+      }
+      Record & r = ring[h & mask];
+      r.ns = ns;
+      r.level = level;
+      r.a = a;
+      r.b = b;
+      r.event = (uint8_t) event;
+      head.store(h+1, std::memory_order_release);
+    }
+
+    uint64_t records() const { return head.load(); }
+    uint64_t stalls() const { return nStalls; }
+
+  private:
+    void flusher();
+
+    std::vector<Record> ring;
+    size_t mask;
+    std::atomic<uint64_t> head, tail;  // written by producer, flusher
+    std::atomic<bool> done;
+    uint64_t nStalls;
+    FILE * file;
+    std::thread thr;
+  };
+
+}
+
+#endif
@@ -0,0 +1,326 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+// Generates families of AIGER instances whose size and answer are
+// known, for measuring how IC3 scales:
+//
+//   genaig <family> <n> [-bug] [-l <limit>] [-o <file>]
+//
+//   counter <n>: an n-bit counter that wraps after <limit> - 1
+//     (default 3 * 2^(n-2)); bad is all 1s.  The proof needs count <
+//     limit; -bug never wraps, so that the counterexample has length
+//     2^n - 1.
+//   shift <n>: two n-stage shift registers on the same input; bad
+//     is their last stages differing.  The proof needs every stage
+//     pair to agree; -bug inverts the second register's middle stage.
+//   fifo <n>: read and write pointers and occupancy of a FIFO with
+//     2^n entries, with push and pop inputs; bad is an occupancy
+//     over 2^n or out of step with the pointers.  -bug lets a push
+//     through when full.
+//   arbiter <n>: a token ring granting one of n requesters per
+//     cycle, where the holder keeps the token while it requests; bad
+//     is two grants at once.  The proof needs the token to be one-
+//     hot; -bug passes the token on while holding it at client n/2.
+//
+// Writes ASCII AIGER to stdout, or to <file> in the format of its
+// extension, with variables in the canonical order that
+// modelFromAiger() expects.
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "aiger.h"
+}
+
+using namespace std;
+
+typedef vector<unsigned> Bits;
+
+// Builds an AIG over a fixed number of inputs and latches.  Variables
+// are allocated inputs first, then latches, then AND gates in creation
+// order, which is the canonical order, so no re-encoding is needed.
+// Constant operands fold away, and equal gates are shared.
+class Builder {
+public:
+  Builder(unsigned inputs, unsigned latches) :
+    nInputs(inputs), next(latches, 0), reset(latches, 0),
+    maxvar(inputs + latches) {}
+
+  unsigned input(unsigned i) const { return 2 * (1 + i); }
+  unsigned latch(unsigned i) const { return 2 * (1 + nInputs + i); }
+  Bits latches(unsigned first, unsigned n) const {
+    Bits v;
+    for (unsigned i = 0; i < n; ++i) v.push_back(latch(first + i));
+    return v;
+  }
+  void setNext(unsigned i, unsigned fn, unsigned init = 0) {
+    next[i] = fn;
+    reset[i] = init;
+  }
+  void setNext(unsigned first, const Bits & fns) {
+    for (size_t i = 0; i < fns.size(); ++i) setNext(first + i, fns[i]);
+  }
+
+  unsigned And(unsigned a, unsigned b) {
+    if (a > b) swap(a, b);
+    if (a == 0 || a == (b ^ 1)) return 0;
+    if (a == 1 || a == b) return b;
+    pair<unsigned, unsigned> key(b, a);
+    map<pair<unsigned, unsigned>, unsigned>::iterator i = gates.find(key);
+    if (i != gates.end()) return i->second;
+    unsigned lhs = 2 * ++maxvar;
+    ands.push_back(key);
+    gates[key] = lhs;
+    return lhs;
+  }
+  unsigned Or(unsigned a, unsigned b) { return And(a ^ 1, b ^ 1) ^ 1; }
+  unsigned Xor(unsigned a, unsigned b) {
+    return Or(And(a, b ^ 1), And(a ^ 1, b));
+  }
+  unsigned Mux(unsigned s, unsigned t, unsigned e) {
+    return Or(And(s, t), And(s ^ 1, e));
+  }
+
+  unsigned equals(const Bits & v, unsigned long c) {
+    unsigned rv = 1;
+    for (size_t i = 0; i < v.size(); ++i)
+      rv = And(rv, v[i] ^ (((c >> i) & 1) ? 0 : 1));
+    return rv;
+  }
+  unsigned equals(const Bits & a, const Bits & b) {
+    unsigned rv = 1;
+    for (size_t i = 0; i < a.size(); ++i)
+      rv = And(rv, Xor(a[i], b[i]) ^ 1);
+    return rv;
+  }
+  // v + cin
+  Bits increment(const Bits & v, unsigned cin) {
+    Bits rv;
+    for (size_t i = 0; i < v.size(); ++i) {
+      rv.push_back(Xor(v[i], cin));
+      cin = And(v[i], cin);
+    }
+    return rv;
+  }
+  // v - bin
+  Bits decrement(const Bits & v, unsigned bin) {
+    Bits rv;
+    for (size_t i = 0; i < v.size(); ++i) {
+      rv.push_back(Xor(v[i], bin));
+      bin = And(v[i] ^ 1, bin);
+    }
+    return rv;
+  }
+  // a - b, as a + ~b + 1
+  Bits subtract(const Bits & a, const Bits & b) {
+    Bits rv;
+    unsigned c = 1;
+    for (size_t i = 0; i < a.size(); ++i) {
+      unsigned nb = b[i] ^ 1;
+      rv.push_back(Xor(Xor(a[i], nb), c));
+      c = Or(And(a[i], nb), And(c, Xor(a[i], nb)));
+    }
+    return rv;
+  }
+  Bits mux(unsigned s, const Bits & t, const Bits & e) {
+    Bits rv;
+    for (size_t i = 0; i < t.size(); ++i) rv.push_back(Mux(s, t[i], e[i]));
+    return rv;
+  }
+
+  aiger * finish(unsigned bad) {
+    aiger * aig = aiger_init();
+    for (unsigned i = 0; i < nInputs; ++i)
+      aiger_add_input(aig, input(i), NULL);
+    for (unsigned i = 0; i < next.size(); ++i) {
+      aiger_add_latch(aig, latch(i), next[i], NULL);
+      if (reset[i]) aiger_add_reset(aig, latch(i), reset[i]);
+    }
+    unsigned lhs = 2 * (nInputs + next.size());
+    for (size_t i = 0; i < ands.size(); ++i)
+      aiger_add_and(aig, lhs += 2, ands[i].first, ands[i].second);
+    aiger_add_output(aig, bad, "bad");
+    return aig;
+  }
+
+private:
+  unsigned nInputs;
+  Bits next, reset;
+  unsigned maxvar;
+  vector<pair<unsigned, unsigned> > ands;
+  map<pair<unsigned, unsigned>, unsigned> gates;
+};
+
+// An enabled n-bit counter that wraps after limit - 1 (not at all
+// when buggy); bad is all 1s
+aiger * counter(unsigned n, unsigned long limit, bool bug) {
+  Builder b(1, n);
+  unsigned en = b.input(0);
+  Bits cnt = b.latches(0, n);
+  unsigned wrap = bug ? 0 : b.And(en, b.equals(cnt, limit - 1));
+  Bits zero(n, 0);
+  b.setNext(0, b.mux(wrap, zero, b.increment(cnt, en)));
+  return b.finish(b.equals(cnt, (1ul << n) - 1));
+}
+
+// Two n-stage shift registers on one input
+aiger * shift(unsigned n, bool bug) {
+  Builder b(1, 2 * n);
+  unsigned in = b.input(0);
+  Bits x = b.latches(0, n), y = b.latches(n, n);
+  for (unsigned i = 0; i < n; ++i) {
+    b.setNext(i, i == 0 ? in : x[i-1]);
+    unsigned yi = i == 0 ? in : y[i-1];
+    b.setNext(n + i, bug && i == n / 2 ? yi ^ 1 : yi);
+  }
+  return b.finish(b.Xor(x[n-1], y[n-1]));
+}
+
+// Pointers (n bits each) and occupancy (n+1 bits) of a 2^n-entry FIFO
+aiger * fifo(unsigned n, bool bug) {
+  Builder b(2, 3 * n + 1);
+  unsigned push = b.input(0), pop = b.input(1);
+  Bits wr = b.latches(0, n), rd = b.latches(n, n);
+  Bits cnt = b.latches(2 * n, n + 1);
+  unsigned long depth = 1ul << n;
+  unsigned full = b.equals(cnt, bug ? depth + 1 : depth);
+  unsigned empty = b.equals(cnt, 0);
+  unsigned doPush = b.And(push, full ^ 1), doPop = b.And(pop, empty ^ 1);
+  b.setNext(0, b.increment(wr, doPush));
+  b.setNext(n, b.increment(rd, doPop));
+  Bits up = b.increment(cnt, b.And(doPush, doPop ^ 1));
+  b.setNext(2 * n, b.decrement(up, b.And(doPop, doPush ^ 1)));
+  // occupancy > 2^n, or occupancy mod 2^n != wr - rd mod 2^n
+  Bits low(cnt.begin(), cnt.begin() + n);
+  unsigned over = b.And(cnt[n], b.equals(low, 0) ^ 1);
+  unsigned skew = b.equals(low, b.subtract(wr, rd)) ^ 1;
+  return b.finish(b.Or(over, skew));
+}
+
+// A token ring over n requesters with registered grants
+aiger * arbiter(unsigned n, bool bug) {
+  Builder b(n, 2 * n);
+  Bits tok = b.latches(0, n), grant = b.latches(n, n);
+  unsigned k = n / 2;
+  for (unsigned i = 0; i < n; ++i) {
+    unsigned p = (i + n - 1) % n;
+    unsigned req = b.input(i), preq = b.input(p);
+    // keep the token while requesting, else pass it on
+    unsigned passed = bug && p == k ? tok[p] : b.And(tok[p], preq ^ 1);
+    b.setNext(i, b.Or(b.And(tok[i], req), passed), i == 0 ? 1 : 0);
+    b.setNext(n + i, b.And(tok[i], req));
+  }
+  // two grants: some grant after an earlier one
+  unsigned seen = 0, two = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    two = b.Or(two, b.And(seen, grant[i]));
+    seen = b.Or(seen, grant[i]);
+  }
+  return b.finish(two);
+}
+
+int usage() {
+  cerr << "usage: genaig counter|shift|fifo|arbiter <n> [-bug] "
+       << "[-l <limit>] [-o <file>]" << endl;
+  return 1;
+}
+
+int main(int argc, char ** argv) {
+  string family, file;
+  unsigned n = 0;
+  unsigned long limit = 0;
+  bool bug = false;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-bug")
+      bug = true;
+    else if (arg == "-l" && i+1 < argc)
+      limit = strtoul(argv[++i], NULL, 10);
+    else if (arg == "-o" && i+1 < argc)
+      file = argv[++i];
+    else if (family.empty())
+      family = arg;
+    else if (n == 0)
+      n = (unsigned) atoi(arg.c_str());
+    else
+      return usage();
+  }
+  if (n == 0) return usage();
+
+  aiger * aig;
+  if (family == "counter") {
+    if (n < 2 || n > 62) {
+      cerr << "counter needs 2 <= n <= 62" << endl;
+      return 1;
+    }
+    if (limit == 0) limit = 3ul << (n - 2);
+    if (limit >= (1ul << n) - 1) {
+      cerr << "limit must be below 2^n - 1" << endl;
+      return 1;
+    }
+    aig = counter(n, limit, bug);
+  }
+  else if (family == "shift")
+    aig = shift(n, bug);
+  else if (family == "fifo") {
+    if (n > 62) {
+      cerr << "fifo needs n <= 62" << endl;
+      return 1;
+    }
+    aig = fifo(n, bug);
+  }
+  else if (family == "arbiter") {
+    if (n < 2) {
+      cerr << "arbiter needs n >= 2" << endl;
+      return 1;
+    }
+    aig = arbiter(n, bug);
+  }
+  else
+    return usage();
+
+  ostringstream what;
+  what << "genaig " << family << " " << n;
+  if (family == "counter") what << " -l " << limit;
+  if (bug) what << " -bug";
+  aiger_add_comment(aig, what.str().c_str());
+  aiger_add_comment(aig, bug ? "expected: unsafe" : "expected: safe");
+
+  int ok;
+  if (file.empty())
+    ok = aiger_write_to_file(aig, aiger_ascii_mode, stdout);
+  else
+    ok = aiger_open_and_write_to_file(aig, file.c_str());
+  aiger_reset(aig);
+  if (!ok) {
+    cerr << "cannot write " << (file.empty() ? "stdout" : file) << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,171 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+// Micro-benchmarks of Model construction, TR loading, and the
+// engine's core queries, for evaluating changes to hot paths in
+// isolation:
+//
+//   micro [-n <reps>] [-c <cube size>] [-seed <n>] [-l <latches>] 
+//         [<AIGER file>]
+//
+// Without a file, it benchmarks a generated counter with <latches>
+// bits.  Reports the median and 90th/99th percentile latencies.
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+extern "C" {
+#include "aiger.h"
+}
+#include "IC3.h"
+#include "Model.h"
+#include "Stats.h"
+
+// An n-bit counter with an enable input; the bad state is all 1s.
+aiger * counter(unsigned n) {
+  aiger * aig = aiger_init();
+  unsigned en = 2, maxvar = 1;
+  aiger_add_input(aig, en, "en");
+  unsigned latch0 = 2 * (maxvar + 1);
+  maxvar += n;
+  // carry[i] = en & l[0] & ... & l[i-1]; next[i] = l[i] ^ carry[i]
+  unsigned carry = en, all = 1;
+  for (unsigned i = 0; i < n; ++i) {
+    unsigned l = latch0 + 2 * i;
+    unsigned a = 2 * ++maxvar, b = 2 * ++maxvar, x = 2 * ++maxvar;
+    aiger_add_and(aig, a, l, carry ^ 1);      // l & ~carry
+    aiger_add_and(aig, b, l ^ 1, carry);      // ~l & carry
+    aiger_add_and(aig, x, a ^ 1, b ^ 1);      // ~(l ^ carry)
+    aiger_add_latch(aig, l, x ^ 1, NULL);
+    unsigned c = 2 * ++maxvar;
+    aiger_add_and(aig, c, carry, l);
+    carry = c;
+    unsigned al = 2 * ++maxvar;
+    aiger_add_and(aig, al, all, l);
+    all = al;
+  }
+  aiger_add_output(aig, all, "bad");
+  // modelFromAiger() relies on the canonical order of variables
+  aiger_reencode(aig);
+  return aig;
+}
+
+void report(IC3::Timings & t) {
+  cout << setw(16) << left << t.name << right << setw(8) << t.ns.size();
+  if (!t.ns.empty())
+    cout << fixed << setprecision(2)
+         << setw(12) << percentile(t.ns, 0.5) / 1e3
+         << setw(12) << percentile(t.ns, 0.9) / 1e3
+         << setw(12) << percentile(t.ns, 0.99) / 1e3;
+  cout << endl;
+}
+
+int main(int argc, char ** argv) {
+  size_t reps = 1000, cubeSize = 8;
+  unsigned seed = 0, latches = 32;
+  const char * file = NULL;
+  string encoding = "tseitin";
+  for (int i = 1; i < argc; ++i) {
+    if (string(argv[i]) == "-n" && i+1 < argc)
+      reps = (size_t) atol(argv[++i]);
+    else if (string(argv[i]) == "-c" && i+1 < argc)
+      cubeSize = (size_t) atol(argv[++i]);
+    else if (string(argv[i]) == "-seed" && i+1 < argc)
+      seed = (unsigned) atol(argv[++i]);
+    else if (string(argv[i]) == "-l" && i+1 < argc)
+      latches = (unsigned) atol(argv[++i]);
+    else if (string(argv[i]) == "-cnf" && i+1 < argc)
+      encoding = argv[++i];
+    else
+      file = argv[i];
+  }
+
+  aiger * aig;
+  if (file) {
+    aig = aiger_init();
+    const char * msg = aiger_open_and_read_from_file(aig, file);
+    if (msg) {
+      cout << msg << endl;
+      return 1;
+    }
+  }
+  else
+    aig = counter(latches);
+
+  vector<IC3::Timings> timings;
+  timings.push_back(IC3::Timings("modelFromAiger"));
+  timings.push_back(IC3::Timings("loadTR (first)"));
+  timings.push_back(IC3::Timings("loadTR (later)"));
+  timings.push_back(IC3::Timings("isInitial"));
+  // Model construction and TR loading, where only the first load
+  // builds the simplified CNF
+  size_t modelReps = max((size_t) 1, reps / 10);
+  for (size_t r = 0; r < modelReps; ++r) {
+    uint64_t start = nanotime();
+    Model * model = modelFromAiger(aig, 0);
+    timings[0].ns.push_back(nanotime() - start);
+    if (!model) return 1;
+    if (!model->setEncoding(encoding)) {
+      cout << "unknown encoding " << encoding << endl;
+      return 1;
+    }
+    for (int j = 1; j <= 2; ++j) {
+      SatSolver * slv = model->newSolver();
+      start = nanotime();
+      model->loadTransitionRelation(*slv);
+      timings[j].ns.push_back(nanotime() - start);
+      delete slv;
+    }
+    delete model;
+  }
+
+  Model * model = modelFromAiger(aig, 0);
+  aiger_reset(aig);
+  if (!model) return 1;
+  model->setEncoding(encoding);
+  size_t nl = model->endLatches() - model->beginLatches();
+  for (size_t r = 0; r < reps; ++r) {
+    LitVec cube;
+    for (size_t i = 0; i < nl && cube.size() < cubeSize; ++i)
+      if (rand_r(&seed) % nl < cubeSize)
+        cube.push_back((model->beginLatches()+i)->lit(rand_r(&seed) % 2));
+    uint64_t start = nanotime();
+    model->isInitial(cube);
+    timings[3].ns.push_back(nanotime() - start);
+  }
+  IC3::microbench(*model, reps, cubeSize, seed, timings);
+  delete model;
+
+  cout << nl << " latches, cubes of " << min(cubeSize, nl) 
+       << " latches, latencies in us" << endl;
+  cout << setw(16) << left << "operation" << right << setw(8) << "n" 
+       << setw(12) << "median" << setw(12) << "p90" << setw(12) << "p99" 
+       << endl;
+  for (vector<IC3::Timings>::iterator i = timings.begin(); 
+       i != timings.end(); ++i)
+    report(*i);
+
+  return 0;
+}
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2013, Aaron Bradley
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Runs IC3 over a directory of AIGER files and writes one CSV row per
+# instance: verdict, wall-clock time, K, # queries, and peak memory,
+# the latter three taken from IC3's JSON statistics (-j).  Given a
+# baseline CSV from an earlier run, flags wrong answers, lost
+# verdicts, and slowdowns, and exits with 1 if there are any.
+#
+#   bench/run.py [options] <dir> [-- <IC3 options>]
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+FIELDS = ['instance', 'verdict', 'time', 'k', 'queries', 'max_rss_kb']
+VERDICTS = {'0': 'safe', '1': 'unsafe', '2': 'unknown'}
+
+
+def instances(root):
+    rv = []
+    for d, _, files in os.walk(root):
+        for f in files:
+            if f.endswith('.aig') or f.endswith('.aag'):
+                rv.append(os.path.join(d, f))
+    # largest first, so that a long run does not start last
+    return sorted(rv, key=lambda p: -os.path.getsize(p))
+
+
+def run(ic3, path, root, timeout, extra):
+    row = dict.fromkeys(FIELDS, '')
+    row['instance'] = os.path.relpath(path, root)
+    fd, jpath = tempfile.mkstemp(suffix='.json')
+    os.close(fd)
+    # IC3 gives up on its own at the timeout; the hard kill is for
+    # when it does not (e.g., stuck in a single long SAT query).
+    cmd = [ic3, '-T', str(timeout), '-j', jpath] + extra
+    start = time.time()
+    try:
+        with open(path, 'rb') as stdin:
+            out = subprocess.run(cmd, stdin=stdin, stdout=subprocess.PIPE,
+                                 stderr=subprocess.DEVNULL,
+                                 timeout=timeout + 5).stdout
+        lines = out.decode(errors='replace').split()
+        row['verdict'] = VERDICTS.get(lines[-1] if lines else '', 'error')
+    except subprocess.TimeoutExpired:
+        row['verdict'] = 'killed'
+    row['time'] = '%.3f' % (time.time() - start)
+    try:
+        with open(jpath) as f:
+            stats = json.loads(f.read().splitlines()[-1])
+        for key in ('k', 'queries', 'max_rss_kb'):
+            row[key] = stats.get(key, '')
+    except (IOError, ValueError, IndexError):
+        pass
+    os.unlink(jpath)
+    return row
+
+
+def load(path):
+    with open(path) as f:
+        return dict((r['instance'], r) for r in csv.DictReader(f))
+
+
+def compare(rows, baseline, slowdown, mintime):
+    problems = []
+    for r in rows:
+        b = baseline.get(r['instance'])
+        if b is None:
+            continue
+        definite = ('safe', 'unsafe')
+        if r['verdict'] in definite and b['verdict'] in definite:
+            if r['verdict'] != b['verdict']:
+                problems.append('WRONG    %s: %s, baseline %s'
+                                % (r['instance'], r['verdict'], b['verdict']))
+                continue
+        elif b['verdict'] in definite:
+            problems.append('LOST     %s: %s, baseline %s'
+                            % (r['instance'], r['verdict'], b['verdict']))
+            continue
+        t, bt = float(r['time']), float(b['time'])
+        if t > slowdown * bt and t - bt > mintime:
+            problems.append('SLOWER   %s: %.2fs, baseline %.2fs (x%.2f)'
+                            % (r['instance'], t, bt, t / max(bt, 1e-3)))
+    return problems
+
+
+def main():
+    argv = sys.argv[1:]
+    extra = []
+    if '--' in argv:
+        extra = argv[argv.index('--') + 1:]
+        argv = argv[:argv.index('--')]
+    ap = argparse.ArgumentParser(description='Run IC3 over a benchmark set.')
+    ap.add_argument('dir', help='directory of .aig/.aag files')
+    ap.add_argument('--ic3', default='./IC3', help='IC3 binary')
+    ap.add_argument('-t', '--timeout', type=float, default=60,
+                    help='seconds per instance')
+    ap.add_argument('-j', '--jobs', type=int, default=1,
+                    help='instances to run in parallel')
+    ap.add_argument('-o', '--output', default='bench.csv', help='CSV file')
+    ap.add_argument('-b', '--baseline', help='CSV of an earlier run')
+    ap.add_argument('--slowdown', type=float, default=1.5,
+                    help='flag runs this many times slower than baseline')
+    ap.add_argument('--min-time', type=float, default=1.0,
+                    help='... and at least this many seconds slower')
+    args = ap.parse_args(argv)
+
+    paths = instances(args.dir)
+    if not paths:
+        sys.exit('no AIGER files in ' + args.dir)
+    rows = []
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = [pool.submit(run, args.ic3, p, args.dir, args.timeout,
+                               extra) for p in paths]
+        for f in futures:
+            r = f.result()
+            print('%-40s %-8s %8ss  k=%s' % (r['instance'], r['verdict'],
+                                             r['time'], r['k']))
+            sys.stdout.flush()
+            rows.append(r)
+    rows.sort(key=lambda r: r['instance'])
+    with open(args.output, 'w', newline='') as f:
+        w = csv.DictWriter(f, fieldnames=FIELDS)
+        w.writeheader()
+        w.writerows(rows)
+
+    solved = sum(1 for r in rows if r['verdict'] in ('safe', 'unsafe'))
+    total = sum(float(r['time']) for r in rows)
+    print('solved %d of %d, %.2fs total' % (solved, len(rows), total))
+    if args.baseline:
+        problems = compare(rows, load(args.baseline), args.slowdown,
+                           args.min_time)
+        for p in problems:
+            print(p)
+        if problems:
+            sys.exit(1)
+        print('no regressions against ' + args.baseline)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,168 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+// A stress test of concurrent checks: threads that each build their
+// own Model of every instance and check it, with varied options, and
+// compare the verdict to the one the instance expects:
+//
+//   stress [-t <threads>] [-r <rounds>] <AIGER file>...
+//
+// Each file must carry the comment "expected: safe" or "expected:
+// unsafe", as genaig writes.  The threads share nothing but the
+// engine's own globals, so a wrong verdict, crash, or hang points to a
+// race; make stress generates the instances and runs it.  To catch races
+// that do not change a verdict, build it with ThreadSanitizer:
+//
+//   make clean && make stress ARCH=-fsanitize=thread
+//
+// which instruments the engine but not Minisat's prebuilt library.
+
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+extern "C" {
+#include "aiger.h"
+}
+#include "IC3.h"
+#include "Model.h"
+
+struct Instance {
+  string file;
+  IC3::Result expected;
+};
+
+const char * verdict(IC3::Result r) {
+  return r == IC3::Safe ? "safe" : r == IC3::Unsafe ? "unsafe" : "unknown";
+}
+
+mutex outMtx;
+size_t checks = 0, failures = 0;
+
+void fail(const Instance & inst, const string & what) {
+  lock_guard<mutex> lock(outMtx);
+  ++failures;
+  cout << inst.file << ": " << what << endl;
+}
+
+// Checks every instance in each round.  The options vary with the
+// thread and round, so that threads run different configurations of
+// the same instance at the same time, and 8 runs cover every
+// combination of encoding, SAT backend, and lifting.
+void worker(const vector<Instance> & insts, unsigned id, unsigned rounds) {
+  for (unsigned r = 0; r < rounds; ++r)
+    for (vector<Instance>::const_iterator i = insts.begin();
+         i != insts.end(); ++i) {
+      aiger * aig = aiger_init();
+      const char * msg = aiger_open_and_read_from_file(aig, i->file.c_str());
+      if (msg) {
+        aiger_reset(aig);
+        fail(*i, msg);
+        continue;
+      }
+      Model * model = modelFromAiger(aig, 0);
+      aiger_reset(aig);
+      if (!model) {
+        fail(*i, "no property");
+        continue;
+      }
+      // thread i's round r runs configuration i * rounds + r
+      unsigned v = id * rounds + r;
+      model->setEncoding(v & 1 ? "compact" : "tseitin");
+      model->setSatBackend(v & 2 ? "minisat-reuse" : "minisat");
+      IC3::Options opts;
+      opts.random = true;
+      opts.seed = 1 + v;
+      opts.ternary = v & 4;
+      opts.share = v % 3 == 0;
+      opts.basic = v % 5 == 4;
+      IC3::Outcome out;
+      IC3::Result res = IC3::check(*model, opts, &out);
+      delete model;
+      if (res != i->expected) {
+        ostringstream what;
+        what << verdict(res) << ", expected " << verdict(i->expected)
+             << " (thread " << id << ", round " << r << ")";
+        fail(*i, what.str());
+      }
+      else if (res == IC3::Unsafe && out.witness.empty())
+        fail(*i, "unsafe without a counterexample");
+      lock_guard<mutex> lock(outMtx);
+      ++checks;
+    }
+}
+
+int main(int argc, char ** argv) {
+  unsigned threads = 4, rounds = 2;
+  vector<Instance> insts;
+  for (int i = 1; i < argc; ++i) {
+    if (string(argv[i]) == "-t" && i+1 < argc)
+      threads = (unsigned) atol(argv[++i]);
+    else if (string(argv[i]) == "-r" && i+1 < argc)
+      rounds = (unsigned) atol(argv[++i]);
+    else {
+      Instance inst;
+      inst.file = argv[i];
+      aiger * aig = aiger_init();
+      const char * msg = aiger_open_and_read_from_file(aig, argv[i]);
+      if (msg) {
+        cout << argv[i] << ": " << msg << endl;
+        return 1;
+      }
+      bool known = false;
+      for (char ** c = aig->comments; c && *c; ++c)
+        if (string(*c) == "expected: safe") {
+          inst.expected = IC3::Safe;
+          known = true;
+        }
+        else if (string(*c) == "expected: unsafe") {
+          inst.expected = IC3::Unsafe;
+          known = true;
+        }
+      aiger_reset(aig);
+      if (!known) {
+        cout << argv[i] << ": no \"expected:\" comment" << endl;
+        return 1;
+      }
+      insts.push_back(inst);
+    }
+  }
+  if (insts.empty() || threads == 0) {
+    cout << "usage: stress [-t <threads>] [-r <rounds>] <AIGER file>..."
+         << endl;
+    return 1;
+  }
+
+  vector<thread> pool;
+  for (unsigned id = 0; id < threads; ++id)
+    pool.push_back(thread(worker, cref(insts), id, rounds));
+  for (vector<thread>::iterator t = pool.begin(); t != pool.end(); ++t)
+    t->join();
+
+  cout << checks << " checks on " << threads << " threads, "
+       << failures << " failed" << endl;
+  return failures ? 1 : 0;
+}
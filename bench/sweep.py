@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2013, Aaron Bradley
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Generates instances of each bench/genaig family over a range of
+# sizes, runs IC3 on them, and reports how time, K, and # queries grow
+# with the number of latches.  Writes one CSV row per instance and
+# exits with 1 if any verdict differs from the known answer.
+#
+#   bench/sweep.py [options] [-- <IC3 options>]
+#
+# Sizes are given per family as <family>:<first>-<last>[:<step>],
+# e.g. "-s fifo:2-8 -s counter:4-16:2"; the safe and buggy variant of
+# each size are run unless -v restricts them.
+
+import argparse
+import csv
+import math
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
+
+from run import run
+
+FAMILIES = ['counter', 'shift', 'fifo', 'arbiter']
+DEFAULT_SIZES = {'counter': (4, 12, 2), 'shift': (8, 64, 8),
+                 'fifo': (2, 7, 1), 'arbiter': (4, 32, 4)}
+FIELDS = ['family', 'n', 'variant', 'latches', 'ands', 'expected',
+          'verdict', 'time', 'k', 'queries', 'max_rss_kb']
+
+
+def parse_sizes(specs):
+    sizes = dict(DEFAULT_SIZES)
+    chosen = []
+    for s in specs:
+        parts = s.split(':')
+        if parts[0] not in FAMILIES or len(parts) > 3:
+            sys.exit('bad size range ' + s)
+        if len(parts) > 1:
+            lo, _, hi = parts[1].partition('-')
+            step = int(parts[2]) if len(parts) == 3 else 1
+            sizes[parts[0]] = (int(lo), int(hi or lo), step)
+        chosen.append(parts[0])
+    return dict((f, sizes[f]) for f in (chosen or FAMILIES))
+
+
+def header(path):
+    # "aag M I L O A": latches and AND gates
+    with open(path) as f:
+        fields = f.readline().split()
+    return int(fields[3]), int(fields[5])
+
+
+def slope(rows, key):
+    # least-squares exponent of key against # latches on a log-log scale
+    pts = [(math.log(r['latches']), math.log(float(r[key])))
+           for r in rows if r['verdict'] == r['expected']
+           and r[key] != '' and float(r[key]) > 0]
+    if len(pts) < 2:
+        return None
+    mx = sum(x for x, _ in pts) / len(pts)
+    my = sum(y for _, y in pts) / len(pts)
+    sxx = sum((x - mx) ** 2 for x, _ in pts)
+    if sxx == 0:
+        return None
+    return sum((x - mx) * (y - my) for x, y in pts) / sxx
+
+
+def main():
+    argv = sys.argv[1:]
+    extra = []
+    if '--' in argv:
+        extra = argv[argv.index('--') + 1:]
+        argv = argv[:argv.index('--')]
+    ap = argparse.ArgumentParser(
+        description='Run IC3 over sweeps of generated instances.')
+    ap.add_argument('-s', '--sizes', action='append', default=[],
+                    help='<family>:<first>-<last>[:<step>] (repeatable)')
+    ap.add_argument('-v', '--variant', choices=['safe', 'bug', 'both'],
+                    default='both')
+    ap.add_argument('--ic3', default='./IC3', help='IC3 binary')
+    ap.add_argument('--genaig', default='./genaig', help='genaig binary')
+    ap.add_argument('-t', '--timeout', type=float, default=60,
+                    help='seconds per instance')
+    ap.add_argument('-j', '--jobs', type=int, default=1,
+                    help='instances to run in parallel')
+    ap.add_argument('-o', '--output', default='sweep.csv', help='CSV file')
+    ap.add_argument('-k', '--keep', metavar='DIR',
+                    help='write the instances to DIR and keep them')
+    args = ap.parse_args(argv)
+
+    root = args.keep or tempfile.mkdtemp(prefix='sweep')
+    os.makedirs(root, exist_ok=True)
+    variants = {'safe': [False], 'bug': [True], 'both': [False, True]}
+    jobs = []
+    for family, (lo, hi, step) in parse_sizes(args.sizes).items():
+        for n in range(lo, hi + 1, max(step, 1)):
+            for bug in variants[args.variant]:
+                name = '%s-%d-%s.aag' % (family, n, 'bug' if bug else 'safe')
+                path = os.path.join(root, name)
+                cmd = [args.genaig, family, str(n), '-o', path]
+                if subprocess.run(cmd + (['-bug'] if bug else [])).returncode:
+                    sys.exit('genaig failed: ' + ' '.join(cmd))
+                jobs.append((family, n, bug, path))
+
+    rows = []
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = [pool.submit(run, args.ic3, path, root, args.timeout,
+                               extra) for _, _, _, path in jobs]
+        for (family, n, bug, path), f in zip(jobs, futures):
+            r = f.result()
+            del r['instance']
+            r['family'], r['n'] = family, n
+            r['variant'] = 'bug' if bug else 'safe'
+            r['expected'] = 'unsafe' if bug else 'safe'
+            r['latches'], r['ands'] = header(path)
+            print('%-8s %4d %-5s %6d latches %-8s %8ss  k=%s' %
+                  (family, n, r['variant'], r['latches'], r['verdict'],
+                   r['time'], r['k']))
+            sys.stdout.flush()
+            rows.append(r)
+    if not args.keep:
+        shutil.rmtree(root)
+    with open(args.output, 'w', newline='') as f:
+        w = csv.DictWriter(f, fieldnames=FIELDS)
+        w.writeheader()
+        w.writerows(rows)
+
+    # scaling: exponent e of time ~ latches^e per family and variant,
+    # over the runs with correct answers
+    print()
+    print('%-8s %-5s %6s %8s %8s %8s' %
+          ('family', 'var.', 'solved', 'time^', 'k^', 'queries^'))
+    wrong = [r for r in rows if r['verdict'] in ('safe', 'unsafe')
+             and r['verdict'] != r['expected']]
+    for family in FAMILIES:
+        for variant in ('safe', 'bug'):
+            sel = [r for r in rows
+                   if r['family'] == family and r['variant'] == variant]
+            if not sel:
+                continue
+            solved = sum(1 for r in sel if r['verdict'] == r['expected'])
+            cols = []
+            for key in ('time', 'k', 'queries'):
+                e = slope(sel, key)
+                cols.append('-' if e is None else '%.2f' % e)
+            print('%-8s %-5s %3d/%-2d %8s %8s %8s' %
+                  ((family, variant, solved, len(sel)) + tuple(cols)))
+    for r in wrong:
+        print('WRONG    %s %d %s: %s' %
+              (r['family'], r['n'], r['variant'], r['verdict']))
+    if wrong:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
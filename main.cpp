@@ -21,20 +21,37 @@ OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 *********************************************************************/
 
+#include <fstream>
 #include <iostream>
 #include <string>
-#include <time.h>
+#include <thread>
 
 extern "C" {
 #include "aiger.h"
 }
+#include "Abstraction.h"
+#include "Cluster.h"
 #include "IC3.h"
 #include "Model.h"
+#include "Reverse.h"
+#include "Service.h"
+#include "Trace.h"
 
 int main(int argc, char ** argv) {
   unsigned int propertyIndex = 0;
-  bool basic = false, random = false;
+  bool basic = false, adaptive = false, random = false, ternary = false,
+    share = false, cegar = false, reverse = false, bidir = false;
   int verbose = 0;
+  IC3::Limits limits;
+  const char * jsonFile = NULL, * traceFile = NULL;
+  bool jsonPerLevel = false;
+  const char * daemonSocket = NULL, * manifest = NULL;
+  string backend = "minisat", encoding = "tseitin";
+  size_t workers = max(1u, thread::hardware_concurrency()), cacheSize = 16;
+  unsigned int seed = 0;
+  size_t runs = 0;
+  const char * coordinator = NULL, * worker = NULL;
+  size_t spawn = 0;
   for (int i = 1; i < argc; ++i) {
     if (string(argv[i]) == "-v")
       // option: verbosity
@@ -45,17 +62,147 @@ int main(int argc, char ** argv) {
     else if (string(argv[i]) == "-r") {
       // option: randomize the run, which is useful in performance
       // testing; default behavior is deterministic
-      srand(time(NULL));
       random = true;
     }
+    else if (string(argv[i]) == "-seed" && i+1 < argc) {
+      // option: randomize with the given seed, to repeat a run
+      random = true;
+      seed = (unsigned) strtoul(argv[++i], NULL, 10);
+    }
+    else if (string(argv[i]) == "-runs" && i+1 < argc)
+      // option: check that many randomized runs in parallel and
+      // report the spread of their performance
+      runs = (size_t) atol(argv[++i]);
     else if (string(argv[i]) == "-b")
       // option: use basic generalization
       basic = true;
+    else if (string(argv[i]) == "-a")
+      // option: tune generalization parameters as the run goes
+      adaptive = true;
+    else if (string(argv[i]) == "-share")
+      // option: share learned clauses implied by the TR between solvers
+      share = true;
+    else if (string(argv[i]) == "-cegar")
+      // option: check abstractions that make latches inputs until
+      // their counterexamples are real (see Abstraction.h)
+      cegar = true;
+    else if (string(argv[i]) == "-reverse")
+      // option: check backward, from the error toward the initial
+      // states (see Reverse.h)
+      reverse = true;
+    else if (string(argv[i]) == "-bidir")
+      // option: check forward and backward at once
+      bidir = true;
+    else if (string(argv[i]) == "-t")
+      // option: lift CTIs by ternary simulation rather than by SAT
+      ternary = true;
+    else if (string(argv[i]) == "-T" && i+1 < argc)
+      // option: wall-clock budget in seconds
+      limits.seconds = atof(argv[++i]);
+    else if (string(argv[i]) == "-C" && i+1 < argc)
+      // option: budget of SAT conflicts
+      limits.conflicts = strtoull(argv[++i], NULL, 10);
+    else if (string(argv[i]) == "-M" && i+1 < argc)
+      // option: memory budget in MB
+      limits.memoryMB = (size_t) atol(argv[++i]);
+    else if (string(argv[i]) == "-j" && i+1 < argc)
+      // option: write final statistics as JSON to a file
+      jsonFile = argv[++i];
+    else if (string(argv[i]) == "-J" && i+1 < argc) {
+      // option: ... and also after each level, one object per line
+      jsonFile = argv[++i];
+      jsonPerLevel = true;
+    }
+    else if (string(argv[i]) == "-trace" && i+1 < argc)
+      // option: write a binary event trace (see tools/tracedump.cpp)
+      traceFile = argv[++i];
+    else if (string(argv[i]) == "-sat" && i+1 < argc) {
+      // option: SAT backend
+      backend = argv[++i];
+      SatSolver * slv = newSatSolver(backend);
+      if (!slv) {
+        cout << "unknown SAT backend " << backend << " (available: " 
+             << satBackends() << ")" << endl;
+        return 0;
+      }
+      delete slv;
+    }
+    else if (string(argv[i]) == "-cnf" && i+1 < argc) {
+      // option: CNF encoding of the AND table
+      encoding = argv[++i];
+      if (encoding != "tseitin" && encoding != "compact") {
+        cout << "unknown encoding " << encoding 
+             << " (available: tseitin, compact)" << endl;
+        return 0;
+      }
+    }
+    else if (string(argv[i]) == "-daemon" && i+1 < argc)
+      // option: serve jobs on a Unix domain socket rather than
+      // checking stdin
+      daemonSocket = argv[++i];
+    else if (string(argv[i]) == "-batch" && i+1 < argc)
+      // option: check the jobs of a manifest rather than stdin
+      manifest = argv[++i];
+    else if (string(argv[i]) == "-coordinator" && i+1 < argc)
+      // option: serve the model to workers that exchange lemmas, at
+      // <host>:<port> or a Unix domain socket (see Cluster.h)
+      coordinator = argv[++i];
+    else if (string(argv[i]) == "-spawn" && i+1 < argc)
+      // option: ... starting that many local workers
+      spawn = (size_t) atol(argv[++i]);
+    else if (string(argv[i]) == "-worker" && i+1 < argc)
+      // option: check the model of the coordinator at the address
+      // rather than stdin
+      worker = argv[++i];
+    else if (string(argv[i]) == "-w" && i+1 < argc)
+      // option: number of worker threads
+      workers = (size_t) atol(argv[++i]);
+    else if (string(argv[i]) == "-cache" && i+1 < argc)
+      // option: number of (file, property) keys in the Model cache
+      cacheSize = (size_t) atol(argv[++i]);
     else
       // optional argument: set property index
       propertyIndex = (unsigned) atoi(argv[i]);
   }
 
+  if (daemonSocket)
+    return Service::serve(daemonSocket, workers, cacheSize);
+  ofstream json;
+  if (jsonFile) {
+    json.open(jsonFile);
+    if (!json) {
+      cout << "cannot open " << jsonFile << endl;
+      return 0;
+    }
+  }
+
+  if (worker) {
+    Service::Job job;
+    job.basic = basic;
+    job.adaptive = adaptive;
+    job.share = share;
+    job.ternary = ternary;
+    job.limits = limits;
+    job.backend = backend;
+    job.encoding = encoding;
+    IC3::Result rv = (IC3::Result) 
+      Cluster::work(worker, job, random ? max(seed, 1u) : 0, verbose, 
+                    jsonFile ? &json : NULL);
+    cout << rv << endl;
+    return 1;
+  }
+  if (manifest) {
+    Service::Job defaults;
+    defaults.basic = basic;
+    defaults.adaptive = adaptive;
+    defaults.share = share;
+    defaults.ternary = ternary;
+    defaults.limits = limits;
+    defaults.backend = backend;
+    defaults.encoding = encoding;
+    return Service::batch(manifest, defaults, workers, cacheSize);
+  }
+
   // read AIGER model
   aiger * aig = aiger_init();
   const char * msg = aiger_read_from_file(aig, stdin);
@@ -63,15 +210,73 @@ int main(int argc, char ** argv) {
     cout << msg << endl;
     return 0;
   }
-  // create the Model from the obtained aig
-  Model * model = modelFromAiger(aig, propertyIndex);
-  aiger_reset(aig);
-  if (!model) return 0;
+  if (runs || coordinator) {
+    Service::Job job;
+    job.property = propertyIndex;
+    job.basic = basic;
+    job.adaptive = adaptive;
+    job.share = share;
+    job.ternary = ternary;
+    job.limits = limits;
+    job.backend = backend;
+    job.encoding = encoding;
+    if (coordinator) {
+      IC3::Result rv = (IC3::Result) 
+        Cluster::coordinate(aig, job, coordinator, spawn, argv[0], verbose);
+      aiger_reset(aig);
+      cout << rv << endl;
+      return 1;
+    }
+    int rv = Service::seeds(aig, job, seed ? seed : 1, runs, workers);
+    aiger_reset(aig);
+    return rv;
+  }
+  // create the Model from the obtained aig, unless checking
+  // abstractions or reversals of it
+  Model * model = NULL;
+  if (!cegar && !reverse && !bidir) {
+    model = modelFromAiger(aig, propertyIndex);
+    aiger_reset(aig);
+    if (!model) return 0;
+    model->setSatBackend(backend);
+    model->setEncoding(encoding);
+  }
+
+  Trace::Writer trace;
+  if (traceFile && !trace.open(traceFile)) {
+    cout << "cannot open " << traceFile << endl;
+    return 0;
+  }
 
   // model check it
-  bool rv = IC3::check(*model, verbose, basic, random);
-  // print 0/1 according to AIGER standard
-  cout << !rv << endl;
+  IC3::Options opts;
+  opts.verbose = verbose;
+  opts.basic = basic;
+  opts.random = random;
+  opts.seed = seed;
+  opts.ternary = ternary;
+  opts.adaptive = adaptive;
+  opts.share = share;
+  opts.limits = limits;
+  opts.json = jsonFile ? &json : NULL;
+  opts.jsonPerLevel = jsonPerLevel;
+  opts.trace = traceFile ? &trace : NULL;
+  IC3::Result rv;
+  if (cegar || reverse || bidir) {
+    if (cegar)
+      rv = Abstraction::check(aig, propertyIndex, backend, encoding, opts);
+    else if (bidir)
+      rv = Reverse::bidirectional(aig, propertyIndex, backend, encoding, 
+                                  opts);
+    else
+      rv = Reverse::check(aig, propertyIndex, backend, encoding, opts);
+    aiger_reset(aig);
+  }
+  else
+    rv = IC3::check(*model, opts);
+  trace.close();
+  // print 0/1/2 according to AIGER standard
+  cout << rv << endl;
 
   delete model;
 
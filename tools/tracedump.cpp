@@ -0,0 +1,92 @@
+/*********************************************************************
+Copyright (c) 2013, Aaron Bradley
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+
+// Decodes a binary event trace written by IC3 -trace (see Trace.h)
+// to CSV, one event per line,
+//
+//   ns,event,level,a,b
+//
+// or, with -json, to JSON Lines, one object per event with the
+// fields named as in Trace.cpp:
+//
+//   {"ns":1234,"event":"lemma","level":3,"size":5,"to_all":1}
+//
+//   tracedump [-json] <trace>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "Trace.h"
+
+using namespace std;
+
+int main(int argc, char ** argv) {
+  bool json = false;
+  const char * path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (string(argv[i]) == "-json")
+      json = true;
+    else
+      path = argv[i];
+  }
+  if (!path) {
+    cerr << "usage: tracedump [-json] <trace>" << endl;
+    return 1;
+  }
+  FILE * f = fopen(path, "rb");
+  if (!f) {
+    cerr << "cannot open " << path << endl;
+    return 1;
+  }
+  Trace::Header h;
+  if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, "IC3T", 4) != 0
+      || h.version != 1 || h.recordSize != sizeof(Trace::Record)) {
+    cerr << path << ": not a version 1 IC3 trace" << endl;
+    fclose(f);
+    return 1;
+  }
+  if (!json) cout << "ns,event,level,a,b\n";
+  Trace::Record buf[4096];
+  size_t n;
+  while ((n = fread(buf, sizeof(Trace::Record), 4096, f)) > 0)
+    for (size_t i = 0; i < n; ++i) {
+      const Trace::Record & r = buf[i];
+      const char * name = Trace::eventName(r.event);
+      if (!json) {
+        cout << r.ns << "," << name << "," << r.level << "," << r.a << "," 
+             << r.b << "\n";
+        continue;
+      }
+      cout << "{\"ns\":" << r.ns << ",\"event\":\"" << name 
+           << "\",\"level\":" << r.level;
+      const char * fa = Trace::fieldName(r.event, 0);
+      const char * fb = Trace::fieldName(r.event, 1);
+      if (*fa) cout << ",\"" << fa << "\":" << r.a;
+      if (*fb) cout << ",\"" << fb << "\":" << r.b;
+      cout << "}\n";
+    }
+  fclose(f);
+  return 0;
+}